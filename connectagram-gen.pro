@@ -0,0 +1,42 @@
+lessThan(QT_VERSION, 4.6) {
+	error("Connectagram requires Qt 4.6 or greater")
+}
+
+TEMPLATE = app
+QT -= gui
+greaterThan(QT_MAJOR_VERSION, 4) {
+	QT += concurrent
+}
+CONFIG += console warn_on
+CONFIG -= app_bundle
+
+VERSION = $$system(git rev-parse --short HEAD)
+isEmpty(VERSION) {
+	VERSION = 0
+}
+DEFINES += VERSIONSTR=\\\"git.$${VERSION}\\\"
+
+TARGET = connectagram-gen
+OBJECTS_DIR = generator
+MOC_DIR = generator
+
+HEADERS = src/alphabet.h \
+	src/alphabets.h \
+	src/cancel_token.h \
+	src/game_cache.h \
+	src/match_kernel.h \
+	src/pattern.h \
+	src/random.h \
+	src/word.h \
+	src/word_dawg.h \
+	src/wordlist.h
+
+SOURCES = src/alphabet.cpp \
+	src/game_cache.cpp \
+	src/generator.cpp \
+	src/match_kernel.cpp \
+	src/pattern.cpp \
+	src/random.cpp \
+	src/word.cpp \
+	src/word_dawg.cpp \
+	src/wordlist.cpp
@@ -5,7 +5,7 @@ lessThan(QT_VERSION, 4.6) {
 TEMPLATE = app
 QT += network
 greaterThan(QT_MAJOR_VERSION, 4) {
-	QT += widgets
+	QT += widgets concurrent
 }
 CONFIG += warn_on
 
@@ -21,13 +21,18 @@ unix: !macx {
 	TARGET = Connectagram
 }
 
-HEADERS = src/board.h \
+HEADERS = src/alphabet.h \
+	src/alphabets.h \
+	src/board.h \
+	src/cancel_token.h \
 	src/cell.h \
 	src/clock.h \
 	src/definitions.h \
 	src/dictionary.h \
+	src/game_cache.h \
 	src/letter.h \
 	src/locale_dialog.h \
+	src/match_kernel.h \
 	src/new_game_dialog.h \
 	src/pattern.h \
 	src/random.h \
@@ -35,16 +40,20 @@ HEADERS = src/board.h \
 	src/view.h \
 	src/window.h \
 	src/word.h \
+	src/word_dawg.h \
 	src/wordlist.h
 
-SOURCES = src/board.cpp \
+SOURCES = src/alphabet.cpp \
+	src/board.cpp \
 	src/cell.cpp \
 	src/clock.cpp \
 	src/definitions.cpp \
 	src/dictionary.cpp \
+	src/game_cache.cpp \
 	src/letter.cpp \
 	src/locale_dialog.cpp \
 	src/main.cpp \
+	src/match_kernel.cpp \
 	src/new_game_dialog.cpp \
 	src/pattern.cpp \
 	src/random.cpp \
@@ -52,10 +61,27 @@ SOURCES = src/board.cpp \
 	src/view.cpp \
 	src/window.cpp \
 	src/word.cpp \
+	src/word_board.cpp \
+	src/word_dawg.cpp \
 	src/wordlist.cpp
 
 TRANSLATIONS = $$files(translations/connectagram_*.ts)
 
+WORDLISTS = $$PWD/data/en/words \
+	$$PWD/data/fr/words \
+	$$PWD/data/hu/words \
+	$$PWD/data/ru/words
+
+system(python3 --version) {
+	wordindex.input = WORDLISTS
+	wordindex.output = ${QMAKE_FILE_IN}.bin
+	wordindex.commands = python3 $$PWD/tools/wordindex.py ${QMAKE_FILE_IN} -o ${QMAKE_FILE_OUT}
+	wordindex.CONFIG = no_link target_predeps
+	QMAKE_EXTRA_COMPILERS += wordindex
+} else {
+	message("Python 3 not found; word lists will be parsed at runtime")
+}
+
 RESOURCES = icons/icons.qrc
 macx {
 	ICON = icons/connectagram.icns
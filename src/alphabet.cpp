@@ -0,0 +1,142 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2013 Graeme Gott <graeme@gottcode.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#include "alphabet.h"
+
+#include "alphabets.h"
+
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+//-----------------------------------------------------------------------------
+
+Alphabet::Alphabet()
+: m_first(0) {
+}
+
+//-----------------------------------------------------------------------------
+
+Alphabet::Alphabet(const ushort* letters, int count)
+: m_first(0) {
+	for (int i = 0; i < count; ++i) {
+		add(QChar(letters[i]));
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+Alphabet Alphabet::forLanguage(const QString& language) {
+	for (int i = 0; i < LANGUAGE_ALPHABETS_COUNT; ++i) {
+		const LanguageAlphabet& alphabet = LANGUAGE_ALPHABETS[i];
+		if (language == QLatin1String(alphabet.language)) {
+			return Alphabet(alphabet.letters, alphabet.count);
+		}
+	}
+	return Alphabet();
+}
+
+//-----------------------------------------------------------------------------
+
+int Alphabet::add(const QChar& letter) {
+	int code = this->code(letter);
+	if (code != -1) {
+		return code;
+	}
+
+	// Counts of every letter must fit in a LetterCounts; no word list comes close
+	if (m_letters.count() >= MAXIMUM_LETTERS) {
+		return -1;
+	}
+
+	// Grow lookup table to span letter
+	int unicode = letter.unicode();
+	if (m_codes.isEmpty()) {
+		m_first = unicode;
+		m_codes.fill(-1, 1);
+	} else if (unicode < m_first) {
+		m_codes.insert(0, m_first - unicode, -1);
+		m_first = unicode;
+	} else if ((unicode - m_first) >= m_codes.count()) {
+		m_codes += QVector<short>(unicode - m_first - m_codes.count() + 1, -1);
+	}
+
+	code = m_letters.count();
+	m_letters.append(letter);
+	m_codes[unicode - m_first] = code;
+	return code;
+}
+
+//-----------------------------------------------------------------------------
+
+static inline int paddedSize(const Alphabet& alphabet) {
+	return qMax(16, (alphabet.count() + 15) & ~15);
+}
+
+//-----------------------------------------------------------------------------
+
+LetterCounts::LetterCounts(const Alphabet& alphabet, const QString& letters)
+: m_size(paddedSize(alphabet)) {
+	memset(m_counts, 0, m_size);
+	foreach (const QChar& c, letters) {
+		int code = alphabet.code(c);
+		if ((code == -1) || (m_counts[code] == 255)) {
+			m_size = 0;
+			return;
+		}
+		m_counts[code]++;
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+LetterCounts::LetterCounts(const Alphabet& alphabet, const char* codes, int length)
+: m_size(paddedSize(alphabet)) {
+	memset(m_counts, 0, m_size);
+	for (int i = 0; i < length; ++i) {
+		m_counts[uchar(codes[i])]++;
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+bool LetterCounts::operator==(const LetterCounts& other) const {
+	int size = m_size;
+	if (size != other.m_size) {
+		return false;
+	}
+
+	// Compare 16 letters at a time
+	const uchar* a = m_counts;
+	const uchar* b = other.m_counts;
+#ifdef __SSE2__
+	for (int i = 0; i < size; i += 16) {
+		__m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+		__m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+		if (_mm_movemask_epi8(_mm_cmpeq_epi8(x, y)) != 0xFFFF) {
+			return false;
+		}
+	}
+	return true;
+#else
+	return memcmp(a, b, size) == 0;
+#endif
+}
@@ -0,0 +1,109 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2013 Graeme Gott <graeme@gottcode.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef ALPHABET_H
+#define ALPHABET_H
+
+#include <QByteArray>
+#include <QChar>
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+// Dense codes for the letters of a language, looked up in a small array
+// that spans from the lowest to the highest letter
+class Alphabet {
+public:
+	// Most letters a word list can use, so that letter counts fit in place
+	enum { MAXIMUM_LETTERS = 64 };
+
+	Alphabet();
+	Alphabet(const ushort* letters, int count);
+
+	static Alphabet forLanguage(const QString& language);
+
+	int add(const QChar& letter);
+
+	int code(const QChar& letter) const {
+		int i = letter.unicode() - m_first;
+		return ((i >= 0) && (i < m_codes.count())) ? m_codes.at(i) : -1;
+	}
+
+	int count() const {
+		return m_letters.count();
+	}
+
+	bool isEmpty() const {
+		return m_letters.isEmpty();
+	}
+
+	QChar letter(int code) const {
+		return m_letters.at(code);
+	}
+
+private:
+	QVector<QChar> m_letters;
+	QVector<short> m_codes;
+	int m_first;
+};
+
+//-----------------------------------------------------------------------------
+
+// Amount of each letter in a word, indexed by alphabet code and padded to a
+// multiple of 16 bytes; words are anagrams when their counts are equal
+class LetterCounts {
+public:
+	LetterCounts() : m_size(0) {
+	}
+
+	LetterCounts(const Alphabet& alphabet, const QString& letters);
+	LetterCounts(const Alphabet& alphabet, const char* codes, int length);
+
+	int count(int code) const {
+		return ((code >= 0) && (code < m_size)) ? m_counts[code] : 0;
+	}
+
+	const char* data() const {
+		return reinterpret_cast<const char*>(m_counts);
+	}
+
+	bool isValid() const {
+		return m_size > 0;
+	}
+
+	int size() const {
+		return m_size;
+	}
+
+	bool operator==(const LetterCounts& other) const;
+
+	bool operator!=(const LetterCounts& other) const {
+		return !(*this == other);
+	}
+
+private:
+	uchar m_counts[Alphabet::MAXIMUM_LETTERS];
+	int m_size;
+};
+
+inline uint qHash(const LetterCounts& counts) {
+	return qHash(QByteArray::fromRawData(counts.data(), counts.size()));
+}
+
+#endif
@@ -0,0 +1,58 @@
+// Generated by tools/alphabets.py; do not edit
+
+#ifndef ALPHABETS_H
+#define ALPHABETS_H
+
+#include <qglobal.h>
+
+struct LanguageAlphabet {
+	const char* language;
+	const ushort* letters;
+	int count;
+};
+
+// ABCDEFGHIJKLMNOPQRSTUVWXYZ
+static const ushort ALPHABET_EN[] = {
+	0x0041, 0x0042, 0x0043, 0x0044, 0x0045, 0x0046, 0x0047, 0x0048,
+	0x0049, 0x004A, 0x004B, 0x004C, 0x004D, 0x004E, 0x004F, 0x0050,
+	0x0051, 0x0052, 0x0053, 0x0054, 0x0055, 0x0056, 0x0057, 0x0058,
+	0x0059, 0x005A,
+};
+
+// .ABCDEFGHIJKLMNOPQRSTUVWXYZÀÂÇÈÉÊËÎÏÔÛÜ
+static const ushort ALPHABET_FR[] = {
+	0x002E, 0x0041, 0x0042, 0x0043, 0x0044, 0x0045, 0x0046, 0x0047,
+	0x0048, 0x0049, 0x004A, 0x004B, 0x004C, 0x004D, 0x004E, 0x004F,
+	0x0050, 0x0051, 0x0052, 0x0053, 0x0054, 0x0055, 0x0056, 0x0057,
+	0x0058, 0x0059, 0x005A, 0x00C0, 0x00C2, 0x00C7, 0x00C8, 0x00C9,
+	0x00CA, 0x00CB, 0x00CE, 0x00CF, 0x00D4, 0x00DB, 0x00DC,
+};
+
+// ABCDEFGHIJKLMNOPQRSTUVWXYZÁÉÍÓÖÚÜŐŰ
+static const ushort ALPHABET_HU[] = {
+	0x0041, 0x0042, 0x0043, 0x0044, 0x0045, 0x0046, 0x0047, 0x0048,
+	0x0049, 0x004A, 0x004B, 0x004C, 0x004D, 0x004E, 0x004F, 0x0050,
+	0x0051, 0x0052, 0x0053, 0x0054, 0x0055, 0x0056, 0x0057, 0x0058,
+	0x0059, 0x005A, 0x00C1, 0x00C9, 0x00CD, 0x00D3, 0x00D6, 0x00DA,
+	0x00DC, 0x0150, 0x0170,
+};
+
+// -АБВГДЕЖЗИЙКЛМНОПРСТУФХЦЧШЩЪЫЬЭЮЯ
+static const ushort ALPHABET_RU[] = {
+	0x002D, 0x0410, 0x0411, 0x0412, 0x0413, 0x0414, 0x0415, 0x0416,
+	0x0417, 0x0418, 0x0419, 0x041A, 0x041B, 0x041C, 0x041D, 0x041E,
+	0x041F, 0x0420, 0x0421, 0x0422, 0x0423, 0x0424, 0x0425, 0x0426,
+	0x0427, 0x0428, 0x0429, 0x042A, 0x042B, 0x042C, 0x042D, 0x042E,
+	0x042F,
+};
+
+static const LanguageAlphabet LANGUAGE_ALPHABETS[] = {
+	{ "en", ALPHABET_EN, 26 },
+	{ "fr", ALPHABET_FR, 39 },
+	{ "hu", ALPHABET_HU, 35 },
+	{ "ru", ALPHABET_RU, 33 }
+};
+
+static const int LANGUAGE_ALPHABETS_COUNT = 4;
+
+#endif
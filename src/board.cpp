@@ -23,24 +23,45 @@
 #include "letter.h"
 #include "pattern.h"
 #include "word.h"
+#include "wordlist.h"
 
+#include <QGraphicsPathItem>
+#include <QHash>
 #include <QLocale>
+#include <QPainterPath>
+#include <QPen>
 #include <QSettings>
+#include <QThreadPool>
 #include <QTimer>
 
+#include <cstdlib>
+#include <ctime>
+
 Board::Board(QObject* parent)
-: QGraphicsScene(parent), m_pattern(0), m_current_word(0), m_hint(0), m_finished(true), m_paused(false) {
+: QGraphicsScene(parent), m_pattern(0), m_prefetch(0), m_prefetch_ready(false), m_preview(0), m_current_word(0), m_hint(0), m_finished(true), m_paused(false) {
 	QTimer* auto_save = new QTimer(this);
 	auto_save->setInterval(30000);
 	connect(auto_save, SIGNAL(timeout()), this, SLOT(saveGame()));
 	auto_save->start();
 
+	m_preview_timer = new QTimer(this);
+	m_preview_timer->setInterval(30);
+	m_preview_timer->setSingleShot(true);
+	connect(m_preview_timer, SIGNAL(timeout()), this, SLOT(updatePreview()));
+
 	m_wordlist = new WordList(this);
 }
 
 //-----------------------------------------------------------------------------
 
 Board::~Board() {
+	// Queued signals are dropped along with the board, so delete patterns at once
+	delete m_prefetch;
+	m_prefetch = 0;
+	qDeleteAll(m_candidates);
+	m_candidates.clear();
+	delete m_pattern;
+	m_pattern = 0;
 	cleanUp();
 }
 
@@ -104,25 +125,66 @@ void Board::setPaused(bool paused) {
 
 //-----------------------------------------------------------------------------
 
-void Board::openGame() {
+void Board::newGame(const QString& language, int pattern, int count, int length) {
+	QSettings settings;
+
+	// Use next game if it was generated in advance
+	if (m_prefetch && (m_prefetch_key == prefetchKey(language, pattern, count, length))) {
+		int seed = m_prefetch->seed();
+		settings.setValue("Current/Seed", seed);
+		startGame(language, pattern, count, length, seed, Pattern::currentVersion());
+		return;
+	}
+	discardStalePrefetch(language, pattern, count, length);
+
+	srand(time(0));
+	int seed = rand();
+	settings.setValue("Current/Seed", seed);
+
+	// Leave a thread free for generating the next game in advance
+	int threads = qMax(1, Pattern::pool()->maxThreadCount() - 1);
+	int candidates = qBound(1, settings.value("NewGame/Candidates", threads).toInt(), threads);
+	if (candidates == 1) {
+		startGame(language, pattern, count, length, seed, Pattern::currentVersion());
+		return;
+	}
+
+	// Generate several seeds at once; the player gets whichever game is generated first
 	cleanUp();
 	emit loading();
 
-	QSettings settings;
-	m_wordlist->setLanguage(settings.value("Current/Language", WordList::defaultLanguage()).toString());
-	m_pattern = Pattern::create(m_wordlist, settings.value("Current/Pattern").toInt());
-	m_pattern->setCount(settings.value("Current/Count").toInt());
-	m_pattern->setLength(settings.value("Current/Length").toInt());
-	m_pattern->setSeed(settings.value("Current/Seed").toInt());
+	m_wordlist->setLanguage(language);
+	for (int i = 0; i < candidates; ++i) {
+		Pattern* candidate = createPattern(language, pattern, count, length, i ? rand() : seed, Pattern::currentVersion());
+		if (i == 0) {
+			setPreview(candidate);
+		}
+		candidate->start();
+		m_candidates.append(candidate);
+	}
+}
 
-	connect(m_pattern, SIGNAL(generated()), this, SLOT(patternGenerated()));
-	m_pattern->start();
+//-----------------------------------------------------------------------------
+
+void Board::openGame() {
+	QSettings settings;
+	startGame(settings.value("Current/Language", WordList::defaultLanguage()).toString(),
+		settings.value("Current/Pattern").toInt(),
+		settings.value("Current/Count").toInt(),
+		settings.value("Current/Length").toInt(),
+		settings.value("Current/Seed").toInt(),
+		settings.value("Current/Version").toInt());
 }
 
 //-----------------------------------------------------------------------------
 
 bool Board::openGame(const QString& number) {
-	if (!number.startsWith("3")) {
+	// Parse version
+	if (number.isEmpty()) {
+		return false;
+	}
+	int version = number.at(0).digitValue();
+	if ((version < 3) || (version > Pattern::currentVersion())) {
 		return false;
 	}
 
@@ -173,17 +235,10 @@ bool Board::openGame(const QString& number) {
 	}
 
 	// Start game
-	cleanUp();
-	emit loading();
-
-	m_wordlist->setLanguage(language);
-	m_pattern = Pattern::create(m_wordlist, pattern);
-	m_pattern->setCount(count);
-	m_pattern->setLength(length);
-	m_pattern->setSeed(seed);
-
-	connect(m_pattern, SIGNAL(generated()), this, SLOT(patternGenerated()));
-	m_pattern->start();
+	if ((pattern < 0) || (pattern >= Pattern::types())) {
+		return false;
+	}
+	startGame(language, pattern, count, length, seed, version);
 
 	return true;
 }
@@ -218,6 +273,65 @@ void Board::togglePaused() {
 //-----------------------------------------------------------------------------
 
 void Board::patternGenerated() {
+	Pattern* pattern = findPattern(sender());
+	if (!pattern) {
+		return;
+	} else if (pattern == m_prefetch) {
+		m_prefetch_ready = true;
+		return;
+	} else if (pattern != m_pattern) {
+		// Keep first game generated and stop the others
+		m_candidates.removeOne(pattern);
+		deleteCandidates();
+		m_pattern = pattern;
+		QSettings().setValue("Current/Seed", pattern->seed());
+	}
+	showPattern();
+}
+
+//-----------------------------------------------------------------------------
+
+void Board::patternFailed() {
+	Pattern* pattern = findPattern(sender());
+	if (!pattern) {
+		return;
+	} else if (pattern == m_prefetch) {
+		discardPattern(m_prefetch);
+		m_prefetch = 0;
+		return;
+	} else if (pattern != m_pattern) {
+		// Only give up once every seed has failed
+		m_candidates.removeOne(pattern);
+		if (pattern == m_preview) {
+			setPreview(0);
+		}
+		discardPattern(pattern);
+		if (!m_candidates.isEmpty()) {
+			return;
+		}
+	}
+	setPreview(0);
+	emit failed();
+}
+
+//-----------------------------------------------------------------------------
+
+void Board::previewChanged() {
+	if (!m_preview || (sender() != m_preview)) {
+		return;
+	}
+
+	// Redraw at most once per interval however fast the pattern changes
+	if (!m_preview_timer->isActive()) {
+		m_preview_timer->start();
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+void Board::showPattern() {
+	setPreview(0);
+
 	m_words = m_pattern->solution();
 	QSize size = m_pattern->size();
 	setSceneRect(0, 0, size.width() * 34 + 2, size.height() * 34 + 34);
@@ -250,9 +364,10 @@ void Board::patternGenerated() {
 		}
 	}
 
+	// Letters were scrambled when the game was generated or cached
 	foreach (Word* word, m_words) {
 		emit wordAdded(word->toString());
-		word->shuffle(m_pattern->words());
+		word->fromString(word->scrambled());
 	}
 
 	QStringList previous = QSettings().value("Current/Words").toStringList();
@@ -264,12 +379,226 @@ void Board::patternGenerated() {
 	saveGame();
 
 	emit started();
+
+	prefetch();
+}
+
+//-----------------------------------------------------------------------------
+
+Pattern* Board::createPattern(const QString& language, int pattern, int count, int length, int seed, int version) {
+	// Each pattern has its own word list to signal when its language is loaded
+	WordList* wordlist = new WordList;
+	wordlist->setLanguage(language);
+	Pattern* result = Pattern::create(wordlist, pattern);
+	wordlist->setParent(result);
+	result->setCount(count);
+	result->setLength(length);
+	result->setSeed(seed);
+	result->setVersion(version);
+
+	connect(result, SIGNAL(generated()), this, SLOT(patternGenerated()));
+	connect(result, SIGNAL(failed()), this, SLOT(patternFailed()));
+	return result;
+}
+
+//-----------------------------------------------------------------------------
+
+void Board::prefetch() {
+	// Generate next game for last used settings while current game is played
+	QSettings settings;
+	QString language = settings.value("NewGame/Language", WordList::defaultLanguage()).toString();
+	int pattern = settings.value("NewGame/Pattern").toInt();
+	int count = settings.value("NewGame/Count", 1).toInt();
+	int length = settings.value("NewGame/Length", 7).toInt();
+	QString key = prefetchKey(language, pattern, count, length);
+	if (m_prefetch && (m_prefetch_key == key)) {
+		return;
+	}
+	discardPattern(m_prefetch);
+	m_prefetch = 0;
+	if ((pattern < 0) || (pattern >= Pattern::types())) {
+		return;
+	}
+
+	srand(time(0) ^ settings.value("Current/Seed").toInt());
+	m_prefetch = createPattern(language, pattern, count, length, rand(), Pattern::currentVersion());
+	m_prefetch_key = key;
+	m_prefetch_ready = false;
+	m_prefetch->start(-1); // queue behind games the player is waiting for
+}
+
+//-----------------------------------------------------------------------------
+
+void Board::setPreview(Pattern* pattern) {
+	m_preview_timer->stop();
+	m_preview = 0;
+	qDeleteAll(m_preview_items);
+	m_preview_items.clear();
+	m_preview_crossings.clear();
+	m_preview_bounds = QRect();
+
+	// Show blank tiles for each word as it is placed while the game is generated
+	if (!pattern || !QSettings().value("Board/RevealWhileLoading", true).toBool()) {
+		return;
+	}
+	m_preview = pattern;
+	m_preview->setIncremental(true);
+	connect(m_preview, SIGNAL(progressChanged()), this, SLOT(previewChanged()), Qt::UniqueConnection);
+
+	// Pattern may already be running, so show the words it has placed so far
+	updatePreview();
+}
+
+//-----------------------------------------------------------------------------
+
+void Board::updatePreview() {
+	QList<QRect> words = m_preview ? m_preview->progress() : QList<QRect>();
+
+	// Count words in each cell and find bounds the same way as the pattern
+	QHash<qint64, int> crossings;
+	QRect bounds;
+	foreach (const QRect& word, words) {
+		for (int x = word.left(); x <= word.right(); ++x) {
+			for (int y = word.top(); y <= word.bottom(); ++y) {
+				crossings[(qint64(x) << 32) | quint32(y)]++;
+			}
+		}
+		bounds |= word;
+	}
+	bool moved = (bounds.topLeft() != m_preview_bounds.topLeft());
+	if (!bounds.isNull() && (bounds.size() != m_preview_bounds.size())) {
+		setSceneRect(0, 0, bounds.width() * 34 + 2, bounds.height() * 34 + 34);
+	}
+	m_preview_bounds = bounds;
+
+	// Remove tiles of cells that no longer have words
+	QMutableHashIterator<qint64, QGraphicsPathItem*> i(m_preview_items);
+	while (i.hasNext()) {
+		i.next();
+		if (!crossings.contains(i.key())) {
+			delete i.value();
+			i.remove();
+		}
+	}
+
+	// Add tiles for new cells and update only cells that changed
+	QPainterPath path;
+	path.addRoundedRect(0, 0, 32, 32, 5, 5);
+	QHashIterator<qint64, int> cell(crossings);
+	while (cell.hasNext()) {
+		cell.next();
+		QGraphicsPathItem* item = m_preview_items.value(cell.key());
+		bool crossed = (cell.value() > 1);
+		if (!item) {
+			item = addPath(path, Qt::NoPen);
+			m_preview_items.insert(cell.key(), item);
+		} else if (!moved && ((m_preview_crossings.value(cell.key()) > 1) == crossed)) {
+			continue;
+		}
+		item->setBrush(crossed ? QColor("#555555") : QColor("#bbbbbb"));
+		int x = int(cell.key() >> 32) - bounds.left();
+		int y = int(qint32(cell.key())) - bounds.top();
+		item->setPos(x * 34 + 2, y * 34 + 34);
+	}
+	m_preview_crossings = crossings;
+}
+
+//-----------------------------------------------------------------------------
+
+QString Board::prefetchKey(const QString& language, int pattern, int count, int length) {
+	return QString("%1/%2/%3/%4").arg(language).arg(pattern).arg(count).arg(length);
+}
+
+//-----------------------------------------------------------------------------
+
+void Board::startGame(const QString& language, int pattern, int count, int length, int seed, int version) {
+	cleanUp();
+	emit loading();
+
+	m_wordlist->setLanguage(language);
+	discardStalePrefetch(language, pattern, count, length);
+
+	// Use next game if it was generated in advance
+	if (m_prefetch
+			&& (m_prefetch_key == prefetchKey(language, pattern, count, length))
+			&& (m_prefetch->seed() == seed)
+			&& (m_prefetch->version() == version)) {
+		m_pattern = m_prefetch;
+		m_prefetch = 0;
+		if (m_prefetch_ready) {
+			showPattern();
+		} else {
+			// Player now waits for this game, so stop queueing it behind others and show its progress
+			m_pattern->promote();
+			setPreview(m_pattern);
+		}
+		return;
+	}
+
+	// Game is read from cache if possible once word list is loaded
+	m_pattern = createPattern(language, pattern, count, length, seed, version);
+	setPreview(m_pattern);
+	m_pattern->start();
+}
+
+//-----------------------------------------------------------------------------
+
+void Board::deleteCandidates() {
+	foreach (Pattern* candidate, m_candidates) {
+		discardPattern(candidate);
+	}
+	m_candidates.clear();
+}
+
+//-----------------------------------------------------------------------------
+
+void Board::discardPattern(Pattern* pattern) {
+	if (!pattern) {
+		return;
+	}
+
+	// Delete once signals already queued by the pattern have been delivered,
+	// so that a new pattern at the same address is never mistaken for it
+	pattern->cancel();
+	disconnect(pattern, 0, this, 0);
+	pattern->deleteLater();
+}
+
+//-----------------------------------------------------------------------------
+
+void Board::discardStalePrefetch(const QString& language, int pattern, int count, int length) {
+	// Stop generating a game for other settings so it does not slow down this one
+	if (m_prefetch && (m_prefetch_key != prefetchKey(language, pattern, count, length))) {
+		discardPattern(m_prefetch);
+		m_prefetch = 0;
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+Pattern* Board::findPattern(const QObject* object) const {
+	// Only compare addresses, as the sender may have been deleted already
+	if (!object) {
+		return 0;
+	} else if (object == m_pattern) {
+		return m_pattern;
+	} else if (object == m_prefetch) {
+		return m_prefetch;
+	}
+	foreach (Pattern* candidate, m_candidates) {
+		if (object == candidate) {
+			return candidate;
+		}
+	}
+	return 0;
 }
 
 //-----------------------------------------------------------------------------
 
 void Board::cleanUp() {
-	delete m_pattern;
+	setPreview(0);
+	deleteCandidates();
+	discardPattern(m_pattern);
 	m_pattern = 0;
 	clear();
 	for (int i = 0; i < m_cells.count(); ++i) {
@@ -24,9 +24,13 @@ class Cell;
 class Pattern;
 class Word;
 class WordList;
+class QGraphicsPathItem;
+class QTimer;
 
 #include <QGraphicsScene>
+#include <QHash>
 #include <QList>
+#include <QRect>
 
 class Board : public QGraphicsScene {
 	Q_OBJECT
@@ -58,6 +62,7 @@ class Board : public QGraphicsScene {
 			return m_wordlist;
 		}
 
+		void newGame(const QString& language, int pattern, int count, int length);
 		void setCurrentWord(Word* word);
 		void setPaused(bool paused);
 
@@ -70,6 +75,7 @@ class Board : public QGraphicsScene {
 
 	signals:
 		void loading();
+		void failed();
 		void finished();
 		void started();
 		void pauseChanged();
@@ -80,13 +86,36 @@ class Board : public QGraphicsScene {
 
 	private slots:
 		void patternGenerated();
+		void patternFailed();
+		void previewChanged();
+		void updatePreview();
 
 	private:
+		Pattern* createPattern(const QString& language, int pattern, int count, int length, int seed, int version);
+		void deleteCandidates();
+		void discardPattern(Pattern* pattern);
+		void discardStalePrefetch(const QString& language, int pattern, int count, int length);
+		Pattern* findPattern(const QObject* object) const;
+		void prefetch();
+		void setPreview(Pattern* pattern);
+		void showPattern();
+		void startGame(const QString& language, int pattern, int count, int length, int seed, int version);
 		void cleanUp();
 
+		static QString prefetchKey(const QString& language, int pattern, int count, int length);
+
 	private:
 		WordList* m_wordlist;
 		Pattern* m_pattern;
+		QList<Pattern*> m_candidates;
+		Pattern* m_prefetch;
+		QString m_prefetch_key;
+		bool m_prefetch_ready;
+		Pattern* m_preview;
+		QTimer* m_preview_timer;
+		QHash<qint64, QGraphicsPathItem*> m_preview_items;
+		QHash<qint64, int> m_preview_crossings;
+		QRect m_preview_bounds;
 		QList<QList<Cell*> > m_cells;
 		QList<Word*> m_words;
 		Word* m_current_word;
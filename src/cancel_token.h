@@ -0,0 +1,51 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2013 Graeme Gott <graeme@gottcode.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef CANCEL_TOKEN_H
+#define CANCEL_TOKEN_H
+
+#include <QAtomicInt>
+
+// Flag that lets another thread stop a long search without taking a lock
+class CancelToken {
+public:
+	CancelToken() : m_cancelled(0) {
+	}
+
+	bool isCancelled() const {
+#if (QT_VERSION >= QT_VERSION_CHECK(5,0,0))
+		return m_cancelled.load();
+#else
+		return m_cancelled;
+#endif
+	}
+
+	void cancel() {
+		m_cancelled.fetchAndStoreOrdered(1);
+	}
+
+	void reset() {
+		m_cancelled.fetchAndStoreOrdered(0);
+	}
+
+private:
+	QAtomicInt m_cancelled;
+};
+
+#endif
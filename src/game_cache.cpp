@@ -0,0 +1,106 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2013 Graeme Gott <graeme@gottcode.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#include "game_cache.h"
+
+#include "pattern.h"
+
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+
+// Bump when the layout of cached games changes
+static const quint32 CACHE_VERSION = 2;
+
+// Amount of games kept before the oldest are removed
+static const int MAXIMUM_GAMES = 200;
+
+// Folder of cached games; games are not cached until it is set
+static QString cache_location;
+
+//-----------------------------------------------------------------------------
+
+bool GameCache::load(Pattern* pattern) {
+	QByteArray hash = pattern->words()->hash();
+	if (hash.isEmpty() || cache_location.isEmpty()) {
+		return false;
+	}
+
+	QFile file(path(pattern));
+	if (!file.open(QFile::ReadOnly)) {
+		return false;
+	}
+	QDataStream stream(&file);
+	stream.setVersion(QDataStream::Qt_4_6);
+
+	// Ignore games generated by older caches or from different word lists
+	quint32 version = 0;
+	QByteArray cached_hash;
+	stream >> version >> cached_hash;
+	if ((version != CACHE_VERSION) || (cached_hash != hash)) {
+		return false;
+	}
+
+	return pattern->readSolution(stream);
+}
+
+//-----------------------------------------------------------------------------
+
+void GameCache::save(const Pattern* pattern) {
+	QByteArray hash = pattern->words()->hash();
+	if (hash.isEmpty() || cache_location.isEmpty() || pattern->solution().isEmpty()) {
+		return;
+	}
+
+	QDir().mkpath(cache_location);
+	QFile file(path(pattern));
+	if (!file.open(QFile::WriteOnly)) {
+		return;
+	}
+	QDataStream stream(&file);
+	stream.setVersion(QDataStream::Qt_4_6);
+	stream << CACHE_VERSION << hash;
+	pattern->writeSolution(stream);
+	file.close();
+
+	prune(cache_location);
+}
+
+//-----------------------------------------------------------------------------
+
+void GameCache::setLocation(const QString& path) {
+	cache_location = path;
+}
+
+//-----------------------------------------------------------------------------
+
+QString GameCache::path(const Pattern* pattern) {
+	return cache_location + "/" + pattern->number();
+}
+
+//-----------------------------------------------------------------------------
+
+void GameCache::prune(const QString& path) {
+	// Remove least recently saved games
+	QFileInfoList games = QDir(path).entryInfoList(QDir::Files, QDir::Time);
+	for (int i = MAXIMUM_GAMES; i < games.count(); ++i) {
+		QFile::remove(games.at(i).absoluteFilePath());
+	}
+}
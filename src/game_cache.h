@@ -0,0 +1,38 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2013 Graeme Gott <graeme@gottcode.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef GAME_CACHE_H
+#define GAME_CACHE_H
+
+class Pattern;
+
+#include <QString>
+
+class GameCache {
+	public:
+		static bool load(Pattern* pattern);
+		static void save(const Pattern* pattern);
+		static void setLocation(const QString& path);
+
+	private:
+		static QString path(const Pattern* pattern);
+		static void prune(const QString& path);
+};
+
+#endif
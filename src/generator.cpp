@@ -0,0 +1,513 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2013 Graeme Gott <graeme@gottcode.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#include "pattern.h"
+#include "random.h"
+#include "word.h"
+#include "wordlist.h"
+
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QMutex>
+#include <QStringList>
+#include <QTextStream>
+#include <QThread>
+#include <QThreadPool>
+#include <QTime>
+#include <QWaitCondition>
+
+#include <cstdio>
+
+//-----------------------------------------------------------------------------
+
+static void usage() {
+	QTextStream err(stderr);
+	err << "Usage: connectagram-gen [options]\n"
+		<< "\n"
+		<< "Generate Connectagram puzzles without a user interface.\n"
+		<< "\n"
+		<< "Options:\n"
+		<< "  --language CODE     word list to use (default: en, or all when\n"
+		<< "                      benchmarking)\n"
+		<< "  --pattern TYPE      pattern number 0-5 or name (default: 0)\n"
+		<< "  --count AMOUNT      amount of words 0-3 (default: 1)\n"
+		<< "  --length LETTERS    letters per word (default: 7)\n"
+		<< "  --seeds FIRST-LAST  inclusive range of seeds (default: 1-100, or 1-5\n"
+		<< "                      when benchmarking)\n"
+		<< "  --format FORMAT     'json' lines or 'binary' (default: json)\n"
+		<< "  --threads AMOUNT    puzzles generated at once (default: all cores)\n"
+		<< "  --data PATH         folder containing word lists\n"
+		<< "  --version VERSION   game version to generate\n"
+		<< "  --compact           store word lists as word graphs to use less\n"
+		<< "                      memory\n"
+		<< "  --benchmark         time loading word lists, filtering, and\n"
+		<< "                      generating every pattern, amount and length\n"
+		<< "                      for each seed; results are JSON lines\n";
+}
+
+//-----------------------------------------------------------------------------
+
+static QString jsonString(const QString& string) {
+	QString result = string;
+	result.replace(QLatin1Char('\\'), QLatin1String("\\\\"));
+	result.replace(QLatin1Char('"'), QLatin1String("\\\""));
+	return QLatin1Char('"') + result + QLatin1Char('"');
+}
+
+//-----------------------------------------------------------------------------
+
+static void writeJson(QTextStream& out, const Pattern* pattern) {
+	out << "{\"number\":" << jsonString(pattern->number())
+		<< ",\"language\":" << jsonString(pattern->words()->language())
+		<< ",\"pattern\":" << pattern->type()
+		<< ",\"count\":" << pattern->wordCount()
+		<< ",\"length\":" << (pattern->wordLength() + 1)
+		<< ",\"seed\":" << pattern->seed()
+		<< ",\"width\":" << pattern->size().width()
+		<< ",\"height\":" << pattern->size().height()
+		<< ",\"words\":[";
+	QList<Word*> words = pattern->solution();
+	for (int i = 0; i < words.count(); ++i) {
+		const Word* word = words.at(i);
+		QPoint pos = word->positions().first();
+		QStringList solutions;
+		foreach (const QString& solution, word->solutions()) {
+			solutions.append(jsonString(solution));
+		}
+		out << ((i > 0) ? ",{" : "{")
+			<< "\"word\":" << jsonString(word->solutions().first())
+			<< ",\"solutions\":[" << solutions.join(",") << "]"
+			<< ",\"scrambled\":" << jsonString(word->scrambled())
+			<< ",\"x\":" << pos.x()
+			<< ",\"y\":" << pos.y()
+			<< ",\"orientation\":" << ((word->orientation() == Qt::Horizontal) ? "\"horizontal\"" : "\"vertical\"")
+			<< "}";
+	}
+	out << "]}\n";
+}
+
+//-----------------------------------------------------------------------------
+
+static void writeResult(QTextStream& out, const QString& benchmark, const QString& language, const QString& details, qreal msecs) {
+	out << "{\"benchmark\":" << jsonString(benchmark)
+		<< ",\"language\":" << jsonString(language)
+		<< details
+		<< ",\"msecs\":" << msecs
+		<< "}\n";
+	out.flush();
+}
+
+//-----------------------------------------------------------------------------
+
+static void benchmark(QTextStream& out, const QStringList& languages, int first_seed, int last_seed) {
+	static const int queries = 1000;
+
+	foreach (const QString& language, languages) {
+		// Time loading word list
+		QTime timer;
+		timer.start();
+		WordList words;
+		words.setLanguage(language);
+
+		// Time how long a job waiting on the word list being loaded takes to stop
+		{
+			Pattern* pattern = Pattern::create(&words, 0);
+			pattern->setSeed(first_seed);
+			pattern->start();
+
+			QMutex mutex;
+			QWaitCondition delay;
+			mutex.lock();
+			delay.wait(&mutex, 5);
+			mutex.unlock();
+
+			QTime cancel_timer;
+			cancel_timer.start();
+			pattern->cancel();
+			pattern->wait();
+			writeResult(out, "cancel-loading", language, QString(), cancel_timer.elapsed());
+			delete pattern;
+		}
+
+		words.waitForReady();
+		writeResult(out, "load", language, QString(), timer.elapsed());
+		if (words.isEmpty()) {
+			continue;
+		}
+
+		for (int length = 5; length <= words.maximumLength(); ++length) {
+			QSharedPointer<const WordBucket> bucket = words.words(length - 1);
+			QStringList all = bucket->filter(QString(length, QLatin1Char('.')));
+			if (all.isEmpty()) {
+				continue;
+			}
+
+			// Create queries that know the first and last letters of random words
+			Random random(first_seed);
+			QStringList known;
+			QStringList letters;
+			for (int i = 0; i < queries; ++i) {
+				QString word = all.at(random.nextInt(all.count()));
+				QString pattern(length, QLatin1Char('.'));
+				pattern[0] = word.at(0);
+				pattern[length - 1] = word.at(length - 1);
+				known.append(pattern);
+				letters.append(word);
+			}
+			QString details = QString(",\"length\":%1,\"words\":%2").arg(length).arg(all.count());
+
+			// Time filtering words by known letters
+			timer.start();
+			for (int i = 0; i < queries; ++i) {
+				bucket->filter(known.at(i));
+			}
+			writeResult(out, "filter", language, details, timer.elapsed() / qreal(queries));
+
+			// Time picking a random match, the search done for each word of a pattern
+			Random picker(first_seed);
+			WordBucket::Scratch scratch;
+			QSet<int> none;
+			timer.start();
+			for (int i = 0; i < queries; ++i) {
+				bucket->randomWord(known.at(i), none, picker, scratch);
+			}
+			writeResult(out, "sample", language, details, timer.elapsed() / qreal(queries));
+
+			// Compare memory of both storages of the same words, timing creating the other one
+			timer.start();
+			QSharedPointer<const WordBucket> other = WordBucket::create(length - 1, all, bucket->alphabet(), !bucket->isCompact());
+			qreal create_msecs = timer.elapsed();
+			const WordBucket* packed = bucket->isCompact() ? other.data() : bucket.data();
+			const WordBucket* compact = bucket->isCompact() ? bucket.data() : other.data();
+			writeResult(out, "memory", language, details + QString(",\"packed_bytes\":%1,\"compact_bytes\":%2").arg(packed->memoryUsage()).arg(compact->memoryUsage()), create_msecs);
+
+			// Time picking from the other storage
+			WordBucket::Scratch other_scratch;
+			Random other_picker(first_seed);
+			timer.start();
+			for (int i = 0; i < queries; ++i) {
+				other->randomWord(known.at(i), none, other_picker, other_scratch);
+			}
+			qreal msecs = timer.elapsed() / qreal(queries);
+
+			// Check that both storages pick the same words for each seed, also when skipping used anagrams
+			int mismatches = 0;
+			for (qint64 seed = first_seed; seed <= last_seed; ++seed) {
+				Random bucket_picker(int(seed));
+				other_picker.setSeed(int(seed));
+				for (int i = 0; i < queries; ++i) {
+					QSet<int> used;
+					if (i & 1) {
+						used.insert(bucket->anagramClass(letters.at(i)));
+					}
+					int id = bucket->randomWord(known.at(i), used, bucket_picker, scratch);
+					mismatches += (id != other->randomWord(known.at(i), used, other_picker, other_scratch));
+				}
+			}
+			if (mismatches) {
+				QTextStream(stderr) << "Packed and compact storage pick different " << language << " words of length " << length << "\n";
+			}
+			writeResult(out, other->isCompact() ? "sample-compact" : "sample-packed", language, details + QString(",\"mismatches\":%1").arg(mismatches), msecs);
+
+			// Time finding alternate solutions, the search done by Word::shuffle() for each generated word
+			timer.start();
+			for (int i = 0; i < queries; ++i) {
+				bucket->anagrams(letters.at(i), known.at(i));
+			}
+			writeResult(out, "anagrams", language, details, timer.elapsed() / qreal(queries));
+
+			// Time scrambling words around their known letters, done for each generated word
+			Random shuffler(first_seed);
+			timer.start();
+			for (int i = 0; i < queries; ++i) {
+				Word word(letters.at(i), QPoint(), Qt::Horizontal, bucket->alphabet(), shuffler);
+				word.shuffle(bucket.data(), known.at(i));
+			}
+			writeResult(out, "shuffle", language, details, timer.elapsed() / qreal(queries));
+		}
+
+		// Time generating every pattern, amount and length, including scrambling the words
+		for (int type = 0; type < Pattern::types(); ++type) {
+			for (int count = 0; count < 4; ++count) {
+				Pattern* pattern = Pattern::create(&words, type);
+				for (int length = pattern->minimumLength(); length <= words.maximumLength(); ++length) {
+					pattern->setCount(count);
+					pattern->setLength(length);
+					QString details = QString(",\"pattern\":%1,\"count\":%2,\"length\":%3").arg(type).arg(count).arg(length);
+					if (!pattern->isFeasible()) {
+						writeResult(out, "generate", language, details + ",\"feasible\":false", 0);
+						continue;
+					}
+
+					int failed = 0;
+					timer.start();
+					for (qint64 seed = first_seed; seed <= last_seed; ++seed) {
+						pattern->setSeed(int(seed));
+						pattern->start();
+						pattern->wait();
+						failed += pattern->solution().isEmpty();
+					}
+					qreal msecs = timer.elapsed() / qreal(last_seed - first_seed + 1);
+					writeResult(out, "generate", language, details + QString(",\"failed\":%1").arg(failed), msecs);
+				}
+				delete pattern;
+			}
+		}
+
+		// Time how long running jobs take to stop, worst case of largest puzzles
+		QMutex mutex;
+		QWaitCondition delay;
+		Random random(first_seed);
+		for (int type = 0; type < Pattern::types(); ++type) {
+			Pattern* pattern = Pattern::create(&words, type);
+			pattern->setCount(3);
+			pattern->setLength(words.maximumLength());
+			QString details = QString(",\"pattern\":%1,\"count\":3,\"length\":%2").arg(type).arg(words.maximumLength());
+			if (!pattern->isFeasible()) {
+				delete pattern;
+				continue;
+			}
+
+			int worst = 0;
+			for (qint64 seed = first_seed; seed <= last_seed; ++seed) {
+				pattern->setSeed(int(seed));
+				pattern->start();
+
+				mutex.lock();
+				delay.wait(&mutex, random.nextInt(20));
+				mutex.unlock();
+
+				timer.start();
+				pattern->cancel();
+				pattern->wait();
+				worst = qMax(worst, timer.elapsed());
+			}
+			writeResult(out, "cancel", language, details, worst);
+			delete pattern;
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+// Each puzzle is written as its seed, width, height and amount of words,
+// followed by the solution, x, y, and horizontal flag of each word
+static void writeBinary(QDataStream& out, const Pattern* pattern) {
+	QList<Word*> words = pattern->solution();
+	out << qint32(pattern->seed())
+		<< quint16(pattern->size().width())
+		<< quint16(pattern->size().height())
+		<< quint16(words.count());
+	foreach (const Word* word, words) {
+		QPoint pos = word->positions().first();
+		out << word->solutions().first()
+			<< quint16(pos.x())
+			<< quint16(pos.y())
+			<< quint8(word->orientation() == Qt::Horizontal);
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+int main(int argc, char** argv) {
+	QCoreApplication app(argc, argv);
+	app.setApplicationName("connectagram-gen");
+	app.setApplicationVersion(VERSIONSTR);
+
+	// Parse arguments
+	QString language;
+	QString type = "0";
+	int count = 1;
+	int length = 7;
+	int first_seed = 1;
+	int last_seed = 100;
+	bool seeds_set = false;
+	QString format = "json";
+	int threads = QThread::idealThreadCount();
+	QString data;
+	int version = Pattern::currentVersion();
+	bool run_benchmark = false;
+	bool compact = false;
+
+	QStringList args = app.arguments().mid(1);
+	bool ok = true;
+	while (ok && !args.isEmpty()) {
+		QString arg = args.takeFirst();
+		if ((arg == "-h") || (arg == "--help")) {
+			usage();
+			return 0;
+		}
+		if (arg == "--benchmark") {
+			run_benchmark = true;
+			continue;
+		}
+		if (arg == "--compact") {
+			compact = true;
+			continue;
+		}
+		if (args.isEmpty()) {
+			ok = false;
+			break;
+		}
+		QString value = args.takeFirst();
+		if (arg == "--language") {
+			language = value;
+		} else if (arg == "--pattern") {
+			type = value.toLower();
+		} else if (arg == "--count") {
+			count = value.toInt(&ok);
+		} else if (arg == "--length") {
+			length = value.toInt(&ok);
+		} else if (arg == "--seeds") {
+			QStringList range = value.split('-');
+			first_seed = range.first().toInt(&ok);
+			last_seed = ok ? range.last().toInt(&ok) : 0;
+			ok &= (range.count() <= 2) && (first_seed <= last_seed);
+			seeds_set = true;
+		} else if (arg == "--format") {
+			format = value;
+			ok = (format == "json") || (format == "binary");
+		} else if (arg == "--threads") {
+			threads = value.toInt(&ok);
+			ok &= (threads > 0);
+		} else if (arg == "--data") {
+			data = value;
+		} else if (arg == "--version") {
+			version = value.toInt(&ok);
+		} else {
+			ok = false;
+		}
+	}
+	if (!ok) {
+		usage();
+		return 1;
+	}
+	WordList::setCompact(compact);
+
+	// Find word lists
+	QStringList paths;
+	if (!data.isEmpty()) {
+		paths.append(data + "/");
+	}
+	QString path = app.applicationDirPath();
+	paths.append(path + "/data/");
+	paths.append(path + "/../share/connectagram/data/");
+	paths.append(path + "/../Resources/data/");
+	QDir::setSearchPaths("connectagram", paths);
+
+	if (run_benchmark) {
+		if (!seeds_set) {
+			last_seed = 5;
+		}
+		QStringList languages(language);
+		if (language.isEmpty()) {
+			languages = QDir("connectagram:").entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+		}
+		QTextStream out(stdout);
+		out.setCodec("UTF-8");
+		benchmark(out, languages, first_seed, last_seed);
+		return 0;
+	}
+	if (language.isEmpty()) {
+		language = "en";
+	}
+
+	// Find pattern
+	int pattern_type = type.toInt(&ok);
+	if (!ok) {
+		pattern_type = -1;
+		WordList names;
+		for (int i = 0; i < Pattern::types(); ++i) {
+			Pattern* pattern = Pattern::create(&names, i);
+			if (pattern->name().toLower() == type) {
+				pattern_type = i;
+			}
+			delete pattern;
+		}
+	}
+	if ((pattern_type < 0) || (pattern_type >= Pattern::types())) {
+		QTextStream(stderr) << "Unknown pattern '" << type << "'\n";
+		return 1;
+	}
+
+	Pattern::pool()->setMaxThreadCount(threads);
+
+	// Load word list; this is done up front so that it is shared by all threads
+	WordList wordlist;
+	wordlist.setLanguage(language);
+	wordlist.waitForReady();
+	if (wordlist.isEmpty()) {
+		QTextStream(stderr) << "Unable to load word list '" << language << "'\n";
+		return 1;
+	}
+
+	// Open output
+	QFile file;
+	file.open(stdout, QIODevice::WriteOnly);
+	QTextStream json(&file);
+	json.setCodec("UTF-8");
+	QDataStream binary(&file);
+	binary.setVersion(QDataStream::Qt_4_6);
+
+	// Generate puzzles in order of seed, keeping every thread busy
+	QTime timer;
+	timer.start();
+	int generated = 0;
+	int failed = 0;
+	qint64 seed = first_seed;
+	QList<Pattern*> running;
+	while (!running.isEmpty() || (seed <= last_seed)) {
+		while ((running.count() < threads) && (seed <= last_seed)) {
+			Pattern* pattern = Pattern::create(&wordlist, pattern_type);
+			pattern->setCount(count);
+			pattern->setLength(length);
+			pattern->setSeed(int(seed));
+			pattern->setVersion(version);
+			pattern->start();
+			running.append(pattern);
+			++seed;
+		}
+
+		Pattern* pattern = running.takeFirst();
+		pattern->wait();
+		if (!pattern->solution().isEmpty()) {
+			if (format == "json") {
+				writeJson(json, pattern);
+				json.flush();
+			} else {
+				writeBinary(binary, pattern);
+			}
+			++generated;
+		} else {
+			QTextStream(stderr) << "Unable to generate puzzle with seed " << pattern->seed() << "\n";
+			++failed;
+		}
+		delete pattern;
+	}
+	file.flush();
+
+	// Report throughput
+	int msecs = qMax(timer.elapsed(), 1);
+	QTextStream(stderr) << "Generated " << generated << " puzzles in " << msecs << " ms ("
+		<< (generated * 1000.0 / msecs) << " puzzles per second), " << failed << " failed\n";
+
+	return failed ? 2 : 0;
+}
@@ -17,11 +17,19 @@
  *
  ***********************************************************************/
 
+#include "game_cache.h"
 #include "locale_dialog.h"
 #include "window.h"
+#include "wordlist.h"
 
 #include <QApplication>
 #include <QDir>
+#include <QSettings>
+#if (QT_VERSION >= QT_VERSION_CHECK(5,0,0))
+#include <QStandardPaths>
+#else
+#include <QDesktopServices>
+#endif
 
 int main(int argc, char** argv) {
 	QApplication app(argc, argv);
@@ -50,6 +58,13 @@ int main(int argc, char** argv) {
 
 	LocaleDialog::loadTranslator("connectagram_");
 
+#if (QT_VERSION >= QT_VERSION_CHECK(5,0,0))
+	GameCache::setLocation(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/games");
+#else
+	GameCache::setLocation(QDesktopServices::storageLocation(QDesktopServices::CacheLocation) + "/games");
+#endif
+	WordList::setCompact(QSettings().value("WordList/Compact", false).toBool());
+
 	Window window;
 
 	return app.exec();
@@ -0,0 +1,157 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2013 Graeme Gott <graeme@gottcode.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#include "match_kernel.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define MATCH_KERNEL_X86
+#include <immintrin.h>
+#endif
+
+//-----------------------------------------------------------------------------
+
+static void matchScalar(const quint64* words, int count, quint64 mask, quint64 value, quint64* matches) {
+	for (int block = 0; (block * 64) < count; ++block) {
+		const quint64* w = words + (block * 64);
+		int end = qMin(count - (block * 64), 64);
+		quint64 bits = 0;
+		for (int i = 0; i < end; ++i) {
+			bits |= quint64((w[i] & mask) == value) << i;
+		}
+		matches[block] &= bits;
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+#ifdef MATCH_KERNEL_X86
+
+__attribute__((target("avx2")))
+static void matchAvx2(const quint64* words, int count, quint64 mask, quint64 value, quint64* matches) {
+	const __m256i m = _mm256_set1_epi64x(mask);
+	const __m256i v = _mm256_set1_epi64x(value);
+	int full = count / 64;
+	for (int block = 0; block < full; ++block) {
+		const quint64* w = words + (block * 64);
+		quint64 bits = 0;
+		for (int i = 0; i < 64; i += 4) {
+			__m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(w + i));
+			__m256i eq = _mm256_cmpeq_epi64(_mm256_and_si256(x, m), v);
+			bits |= quint64(_mm256_movemask_pd(_mm256_castsi256_pd(eq))) << i;
+		}
+		matches[block] &= bits;
+	}
+	if (count > (full * 64)) {
+		matchScalar(words + (full * 64), count - (full * 64), mask, value, matches + full);
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+__attribute__((target("sse4.1")))
+static void matchSse41(const quint64* words, int count, quint64 mask, quint64 value, quint64* matches) {
+	const __m128i m = _mm_set1_epi64x(mask);
+	const __m128i v = _mm_set1_epi64x(value);
+	int full = count / 64;
+	for (int block = 0; block < full; ++block) {
+		const quint64* w = words + (block * 64);
+		quint64 bits = 0;
+		for (int i = 0; i < 64; i += 2) {
+			__m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(w + i));
+			__m128i eq = _mm_cmpeq_epi64(_mm_and_si128(x, m), v);
+			bits |= quint64(_mm_movemask_pd(_mm_castsi128_pd(eq))) << i;
+		}
+		matches[block] &= bits;
+	}
+	if (count > (full * 64)) {
+		matchScalar(words + (full * 64), count - (full * 64), mask, value, matches + full);
+	}
+}
+
+#endif
+
+//-----------------------------------------------------------------------------
+
+static inline int popcount(quint64 bits) {
+#ifdef __GNUC__
+	return __builtin_popcountll(bits);
+#else
+	bits = bits - ((bits >> 1) & Q_UINT64_C(0x5555555555555555));
+	bits = (bits & Q_UINT64_C(0x3333333333333333)) + ((bits >> 2) & Q_UINT64_C(0x3333333333333333));
+	bits = (bits + (bits >> 4)) & Q_UINT64_C(0x0F0F0F0F0F0F0F0F);
+	return int((bits * Q_UINT64_C(0x0101010101010101)) >> 56);
+#endif
+}
+
+//-----------------------------------------------------------------------------
+
+typedef void (*MatchFunction)(const quint64*, int, quint64, quint64, quint64*);
+
+static MatchFunction detectMatchFunction() {
+#ifdef MATCH_KERNEL_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) {
+		return matchAvx2;
+	} else if (__builtin_cpu_supports("sse4.1")) {
+		return matchSse41;
+	}
+#endif
+	return matchScalar;
+}
+
+//-----------------------------------------------------------------------------
+
+void matchPackedWords(const quint64* words, int count, quint64 mask, quint64 value, quint64* matches) {
+	static const MatchFunction function = detectMatchFunction();
+	function(words, count, mask, value, matches);
+}
+
+//-----------------------------------------------------------------------------
+
+int countMatches(const quint64* matches, int blocks) {
+	int result = 0;
+	for (int i = 0; i < blocks; ++i) {
+		result += popcount(matches[i]);
+	}
+	return result;
+}
+
+//-----------------------------------------------------------------------------
+
+int selectMatch(const quint64* matches, int blocks, int k) {
+	// Skip whole blocks, then drop lowest bits of block holding match
+	for (int i = 0; (i < blocks) && (k >= 0); ++i) {
+		quint64 bits = matches[i];
+		int count = popcount(bits);
+		if (k >= count) {
+			k -= count;
+			continue;
+		}
+		for (; k > 0; --k) {
+			bits &= bits - 1;
+		}
+		int index = 0;
+		while (!(bits & 1)) {
+			bits >>= 1;
+			++index;
+		}
+		return (i * 64) + index;
+	}
+	return -1;
+}
@@ -0,0 +1,35 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2013 Graeme Gott <graeme@gottcode.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef MATCH_KERNEL_H
+#define MATCH_KERNEL_H
+
+#include <qglobal.h>
+
+// Clear bit i of matches for each word where (words[i] & mask) != value;
+// matches holds one bit per word, 64 words per element
+void matchPackedWords(const quint64* words, int count, quint64 mask, quint64 value, quint64* matches);
+
+// Amount of set bits in matches
+int countMatches(const quint64* matches, int blocks);
+
+// Index of set bit k of matches, counting from zero, or -1 if there are fewer
+int selectMatch(const quint64* matches, int blocks, int k);
+
+#endif
@@ -37,16 +37,13 @@
 #include <QToolButton>
 #include <QVBoxLayout>
 
-#include <cstdlib>
-#include <ctime>
-
 NewGameDialog::NewGameDialog(Board* board, QWidget* parent)
-: QDialog(parent, Qt::WindowTitleHint | Qt::WindowSystemMenuHint | Qt::WindowCloseButtonHint), m_board(board) {
+: QDialog(parent, Qt::WindowTitleHint | Qt::WindowSystemMenuHint | Qt::WindowCloseButtonHint), m_board(board), m_length(0) {
 	setWindowTitle(tr("New Game"));
 
 	// Create languages box
 	m_wordlist = new WordList(this);
-	m_wordlist->setLanguage(WordList::defaultLanguage());
+	connect(m_wordlist, SIGNAL(ready()), this, SLOT(wordListReady()));
 	m_languages_box = new QComboBox(this);
 	QStringList languages = QDir("connectagram:").entryList(QDir::Dirs | QDir::NoDotAndDotDot);
 	foreach (const QString& language, languages) {
@@ -56,6 +53,7 @@ NewGameDialog::NewGameDialog(Board* board, QWidget* parent)
 	// Create word count box
 	m_word_count_box = new QComboBox(this);
 	m_word_count_box->addItems(QStringList() << tr("Low") << tr("Medium") << tr("High") << tr("Very High"));
+	connect(m_word_count_box, SIGNAL(activated(int)), this, SLOT(countSelected()));
 
 	// Create word length box
 	m_word_length_box = new QComboBox(this);
@@ -134,23 +132,40 @@ void NewGameDialog::keyPressEvent(QKeyEvent* event) {
 
 //-----------------------------------------------------------------------------
 
-void NewGameDialog::languageSelected(int index) {
-	m_wordlist->setLanguage(m_languages_box->itemData(index).toString());
+void NewGameDialog::countSelected() {
+	lengthSelected(m_word_length_box->currentIndex());
+}
 
-	int length = m_word_length_box->itemData(m_word_length_box->currentIndex()).toInt();
-	m_word_length_box->clear();
-	for (int i = 5; i <= m_wordlist->maximumLength(); ++i) {
-		m_word_length_box->addItem(tr("%n letter(s)", "", i), i);
+//-----------------------------------------------------------------------------
+
+void NewGameDialog::languageSelected(int index) {
+	// Disable lengths and patterns until words are loaded
+	m_word_length_box->setEnabled(false);
+	foreach (QToolButton* button, m_pattern_buttons) {
+		button->setEnabled(false);
 	}
-	setLength(length);
+	m_wordlist->setLanguage(m_languages_box->itemData(index).toString());
 }
 
 //-----------------------------------------------------------------------------
 
 void NewGameDialog::lengthSelected(int index) {
+	if (!m_wordlist->isReady()) {
+		return;
+	}
+
+	int count = m_word_count_box->currentIndex();
 	int length = m_word_length_box->itemData(index).toInt();
+	m_length = length;
 	for (int i = 0; i < m_pattern_buttons.count(); ++i) {
-		m_pattern_buttons.at(i)->setEnabled(length >= m_patterns.at(i)->minimumLength());
+		Pattern* pattern = m_patterns.at(i);
+		bool enabled = (length >= pattern->minimumLength());
+		if (enabled) {
+			pattern->setCount(count);
+			pattern->setLength(length);
+			enabled = pattern->isFeasible();
+		}
+		m_pattern_buttons.at(i)->setEnabled(enabled);
 	}
 }
 
@@ -171,8 +186,6 @@ void NewGameDialog::patternSelected() {
 	QString language = m_languages_box->itemData(m_languages_box->currentIndex()).toString();
 	int count = m_word_count_box->currentIndex();
 	int length = m_word_length_box->itemData(m_word_length_box->currentIndex()).toInt();
-	srand(time(0));
-	int seed = rand();
 
 	QSettings settings;
 	settings.remove("Current");
@@ -180,15 +193,14 @@ void NewGameDialog::patternSelected() {
 	settings.setValue("NewGame/Pattern", pattern);
 	settings.setValue("NewGame/Count", count);
 	settings.setValue("NewGame/Length", length);
-	settings.setValue("Current/Version", 3);
+	settings.setValue("Current/Version", Pattern::currentVersion());
 	settings.setValue("Current/Language", language);
 	settings.setValue("Current/Pattern", pattern);
 	settings.setValue("Current/Count", count);
 	settings.setValue("Current/Length", length);
-	settings.setValue("Current/Seed", seed);
 	settings.setValue("Current/Time", 0);
 
-	m_board->openGame();
+	m_board->newGame(language, pattern, count, length);
 
 	accept();
 }
@@ -211,11 +223,28 @@ void NewGameDialog::setLanguage(const QString& language) {
 void NewGameDialog::setCount(int count) {
 	count = qBound(0, count, 3);
 	m_word_count_box->setCurrentIndex(count);
+	countSelected();
+}
+
+//-----------------------------------------------------------------------------
+
+void NewGameDialog::wordListReady() {
+	m_word_length_box->clear();
+	for (int i = 5; i <= m_wordlist->maximumLength(); ++i) {
+		m_word_length_box->addItem(tr("%n letter(s)", "", i), i);
+	}
+	m_word_length_box->setEnabled(true);
+	setLength(m_length);
 }
 
 //-----------------------------------------------------------------------------
 
 void NewGameDialog::setLength(int length) {
+	m_length = length;
+	if (!m_wordlist->isReady()) {
+		return;
+	}
+
 	int min = m_word_length_box->itemData(0).toInt();
 	int max = m_word_length_box->itemData(m_word_length_box->count() - 1).toInt();
 	m_word_length_box->setCurrentIndex(qBound(min, length, max) - min);
@@ -40,9 +40,11 @@ class NewGameDialog : public QDialog {
 		void keyPressEvent(QKeyEvent* event);
 
 	private slots:
+		void countSelected();
 		void languageSelected(int index);
 		void lengthSelected(int index);
 		void patternSelected();
+		void wordListReady();
 
 	private:
 		void setLanguage(const QString& language);
@@ -57,6 +59,7 @@ class NewGameDialog : public QDialog {
 		QList<Pattern*> m_patterns;
 		Board* m_board;
 		WordList* m_wordlist;
+		int m_length;
 };
 
 #endif
@@ -19,29 +19,86 @@
 
 #include "pattern.h"
 
+#include "game_cache.h"
 #include "word.h"
 
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+#include <QTime>
+
+// Limits on generating a single puzzle before giving up
+static const int MAXIMUM_RESTARTS = 5000;
+static const int MAXIMUM_MSECS = 15000;
+
+//-----------------------------------------------------------------------------
+
+// Generates a pattern in one of the threads of Pattern::pool()
+class Pattern::Job : public QRunnable {
+	public:
+		Job(Pattern* pattern) : m_pattern(pattern) {
+		}
+
+		void run() {
+			m_pattern->m_job_mutex.lock();
+			m_pattern->m_job = 0;
+			m_pattern->m_job_mutex.unlock();
+
+			m_pattern->generate();
+			m_pattern->finish();
+		}
+
+	private:
+		Pattern* m_pattern;
+};
+
 //-----------------------------------------------------------------------------
 
 Pattern::Pattern(WordList* words)
-: m_current(0,0), m_words(words), m_count(0), m_length(0), m_seed(0), m_cancelled(false) {
+: m_current(0,0), m_words(words), m_count(0), m_length(0), m_seed(0), m_type(0), m_version(currentVersion()), m_incremental(false), m_progress_changed(false), m_running(false), m_job(0) {
 	Q_ASSERT(words != 0);
 }
 
 //-----------------------------------------------------------------------------
 
 Pattern::~Pattern() {
-	if (isRunning()) {
-		m_cancelled_mutex.lock();
-		m_cancelled = true;
-		m_cancelled_mutex.unlock();
-		wait();
-	}
+	cancel();
+	wait();
 	cleanUp();
 }
 
 //-----------------------------------------------------------------------------
 
+QString Pattern::number() const {
+	return QString::number(m_version)
+		+ m_words->language()
+		+ QString::number(m_type)
+		+ QString::number(wordCount())
+		+ QString("%1").arg(int(m_length - 4), 2, 16, QLatin1Char('0'))
+		+ QString::number(m_seed, 16);
+}
+
+//-----------------------------------------------------------------------------
+
+bool Pattern::isFeasible() const {
+	// Each word needs different letters than all other words
+	WordStats stats = m_words->stats(m_length);
+	int classes = stats.anagram_classes;
+	if (classes < m_count) {
+		return false;
+	}
+
+	// Estimate how many words can fit the letters of crossing words
+	qreal matches = classes;
+	qreal probability = stats.match_probability;
+	for (int i = 0; i < crossings(); ++i) {
+		matches *= probability;
+	}
+	return matches >= 1.0;
+}
+
+//-----------------------------------------------------------------------------
+
 void Pattern::setCount(int count) {
 	m_count = counts().value(count, 4);
 }
@@ -49,8 +106,8 @@ void Pattern::setCount(int count) {
 //-----------------------------------------------------------------------------
 
 void Pattern::setLength(int length) {
-	m_length = qBound(minimumLength(), length, maximumLength()) - 1;
-	m_words->setLength(m_length);
+	// Length is bounded by word list once it is loaded in generate()
+	m_length = qMax(minimumLength(), length) - 1;
 }
 
 //-----------------------------------------------------------------------------
@@ -61,6 +118,142 @@ void Pattern::setSeed(int seed) {
 
 //-----------------------------------------------------------------------------
 
+void Pattern::setIncremental(bool incremental) {
+	QMutexLocker locker(&m_progress_mutex);
+	m_incremental = incremental;
+	m_progress_changed = false;
+}
+
+//-----------------------------------------------------------------------------
+
+void Pattern::setVersion(int version) {
+	m_version = qBound(3, version, currentVersion());
+}
+
+//-----------------------------------------------------------------------------
+
+QList<QRect> Pattern::progress() {
+	QMutexLocker locker(&m_progress_mutex);
+	m_progress_changed = false;
+	return m_progress;
+}
+
+//-----------------------------------------------------------------------------
+
+bool Pattern::readSolution(QDataStream& stream) {
+	cleanUp();
+
+	QSize size;
+	qint32 count = 0;
+	stream >> size >> count;
+	if ((stream.status() != QDataStream::Ok) || size.isEmpty() || (count != m_count)) {
+		return false;
+	}
+
+	QRect bounds(QPoint(0, 0), size);
+	QSharedPointer<const WordBucket> words = m_words->words(m_length);
+	for (int i = 0; i < count; ++i) {
+		QPoint position;
+		qint32 orientation = 0;
+		QStringList solutions;
+		QString scrambled;
+		stream >> position >> orientation >> solutions >> scrambled;
+		if ((stream.status() != QDataStream::Ok)
+				|| ((orientation != Qt::Horizontal) && (orientation != Qt::Vertical))
+				|| solutions.isEmpty()
+				|| (solutions.first().length() != (m_length + 1))) {
+			cleanUp();
+			return false;
+		}
+
+		Word* word = new Word(solutions.first(), position, Qt::Orientation(orientation), words->alphabet(), m_random);
+		m_solution.append(word);
+		if (!bounds.contains(word->positions().first()) || !bounds.contains(word->positions().last())
+				|| !word->restore(solutions, scrambled)) {
+			cleanUp();
+			return false;
+		}
+	}
+
+	m_size = size;
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+
+void Pattern::writeSolution(QDataStream& stream) const {
+	stream << m_size << qint32(m_solution.count());
+	foreach (Word* word, m_solution) {
+		stream << word->positions().first() << qint32(word->orientation()) << QStringList(word->solutions()) << word->scrambled();
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+bool Pattern::isRunning() const {
+	QMutexLocker locker(&m_job_mutex);
+	return m_running;
+}
+
+//-----------------------------------------------------------------------------
+
+void Pattern::cancel() {
+	m_cancel.cancel();
+}
+
+//-----------------------------------------------------------------------------
+
+void Pattern::start(int priority) {
+	QMutexLocker locker(&m_job_mutex);
+	if (m_running) {
+		return;
+	}
+	m_running = true;
+	m_cancel.reset();
+
+	// Job forgets itself once it leaves the queue
+	m_job = new Job(this);
+	pool()->start(m_job, priority);
+}
+
+//-----------------------------------------------------------------------------
+
+void Pattern::promote() {
+	// Move job that has not started yet to the front of the queue
+#if (QT_VERSION >= QT_VERSION_CHECK(5,9,0))
+	QMutexLocker locker(&m_job_mutex);
+	if (m_job && pool()->tryTake(m_job)) {
+		pool()->start(m_job, 0);
+	}
+#endif
+}
+
+//-----------------------------------------------------------------------------
+
+void Pattern::wait() {
+	QMutexLocker locker(&m_job_mutex);
+	while (m_running) {
+		m_job_finished.wait(&m_job_mutex);
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+QThreadPool* Pattern::pool() {
+	// Keep threads around between games; use at least two so that a game
+	// being prefetched never holds up the game the player is waiting for
+	static QThreadPool threads;
+	static bool initialized = false;
+	if (!initialized) {
+		threads.setExpiryTimeout(-1);
+		threads.setMaxThreadCount(qMax(2, QThread::idealThreadCount()));
+		initialized = true;
+	}
+	return &threads;
+}
+
+//-----------------------------------------------------------------------------
+
 Pattern* Pattern::create(WordList* words, int type) {
 	Pattern* pattern = 0;
 	switch (type) {
@@ -85,12 +278,15 @@ Pattern* Pattern::create(WordList* words, int type) {
 		default:
 			break;
 	}
+	if (pattern) {
+		pattern->m_type = type;
+	}
 	return pattern;
 }
 
 //-----------------------------------------------------------------------------
 
-Word* Pattern::addRandomWord(Qt::Orientation orientation) {
+Word* Pattern::addRandomWord(Qt::Orientation orientation, const CancelToken& cancel) {
 	// Filter words on what characters are on the board
 	QString known_letters;
 	QPoint pos = m_current;
@@ -100,125 +296,246 @@ Word* Pattern::addRandomWord(Qt::Orientation orientation) {
 		known_letters.append(c.isNull() ? QChar('.') : c);
 		pos += delta;
 	}
-	QStringList words = m_words->filter(known_letters);
+	if (cancel.isCancelled()) {
+		return 0;
+	}
 
 	// Find word
-	QString result = !words.isEmpty() ? words.at(randomInt(words.count())) : QString();
+	QString result = m_filter.randomWord(known_letters, m_random, &cancel);
 	if (result.isEmpty()) {
 		return 0;
 	}
 
 	// Remove anagrams of word
-	m_words->addAnagramFilter(result);
+	m_filter.addAnagramFilter(result);
 
-	return new Word(result, m_current, orientation, m_random);
+	return new Word(result, m_current, orientation, m_filter.words()->alphabet(), m_random);
 }
 
 //-----------------------------------------------------------------------------
 
 QChar Pattern::at(const QPoint& pos) const {
-	foreach (Word* word, m_solution) {
-		QList<QPoint> positions = word->positions();
-		for (int i = 0; i < positions.count(); ++i) {
-			if (positions.at(i) == pos) {
-				return word->at(i);
-			}
-		}
-	}
-	return QChar();
+	return m_grid.value(gridKey(pos)).letter;
 }
 
 //-----------------------------------------------------------------------------
 
-void Pattern::run() {
-	if (m_words->isEmpty()) {
+void Pattern::generate() {
+	if (!m_words->waitForReady(&m_cancel) || m_cancel.isCancelled()) {
+		return;
+	}
+	m_length = qBound(minimumLength(), m_length + 1, maximumLength()) - 1;
+	m_filter = WordFilter(m_words->words(m_length));
+
+	int count = counts().value(wordCount());
+	if (m_words->isEmpty() || (m_filter.words()->anagramClassCount() < count)) {
+		emit failed();
+		return;
+	}
+
+	// Reuse game generated before; its number depends on the bounded length
+	if (GameCache::load(this)) {
+		emit generated();
 		return;
 	}
 
 	m_random.setSeed(m_seed);
 
 	// Add words
-	cleanUp();
+	restart();
 	int s = steps();
-	int count = counts().value(wordCount());
+	QVector<QPoint> currents(count);
+	int backtracks = 0;
+	int restarts = 0;
+	QTime timer;
+	timer.start();
 	for (int i = 0; i < count; ++i) {
-		Word* word = addWord(i % s);
-		if (word) {
+		currents[i] = m_current;
+		Word* word = addWord(i % s, m_cancel);
+		if (m_cancel.isCancelled()) {
+			delete word;
+			return;
+		} else if (word) {
 			m_solution.append(word);
+			addToGrid(word);
+			updateProgress();
+		} else if ((m_version > 3) && (i > 0) && (backtracks < (count * s))) {
+			// Undo up to one round of steps and try them again
+			int undo = qMin(i, (backtracks % s) + 1);
+			++backtracks;
+			for (int j = 0; j < undo; ++j) {
+				removeLastWord();
+			}
+			updateProgress();
+			i -= undo;
+			m_current = currents.at(i);
+			--i;
 		} else {
-			cleanUp();
+			restart();
 			i = -1;
+			backtracks = 0;
+			restarts++;
 		}
 
-		QMutexLocker locker(&m_cancelled_mutex);
-		if (m_cancelled) {
+		// Give up if puzzle is taking too long
+		if ((restarts > MAXIMUM_RESTARTS) || (timer.elapsed() > MAXIMUM_MSECS)) {
+			restart();
+			emit failed();
 			return;
 		}
 	}
 
-	// Move words so that no positions are negative
-	int x1 = 0x7FFFFFFF;
-	int x2 = -x1;
-	int y1 = x1;
-	int y2 = x2;
+	// Find alternate solutions and scramble letters; crossed letters stay in place
 	foreach (Word* word, m_solution) {
-		QList<QPoint> positions = word->positions();
-		foreach (const QPoint& pos, positions) {
-			x1 = qMin(x1, pos.x());
-			y1 = qMin(y1, pos.y());
-			x2 = qMax(x2, pos.x());
-			y2 = qMax(y2, pos.y());
+		if (m_cancel.isCancelled()) {
+			return;
 		}
+		QString known_letters;
+		foreach (const QPoint& pos, word->positions()) {
+			known_letters.append((m_grid.value(gridKey(pos)).words > 1) ? at(pos) : QChar('.'));
+		}
+		word->shuffle(m_filter.words(), known_letters);
 	}
-	m_size = QSize(x2 - x1 + 1, y2 - y1 + 1);
 
-	QPoint delta = QPoint(-x1, -y1);
+	// Move words so that no positions are negative
+	m_size = m_bounds.size();
+
+	QPoint delta = -m_bounds.topLeft();
 	foreach (Word* word, m_solution) {
 		word->moveBy(delta);
 	}
 
-	m_words->resetAnagramFilters();
+	m_grid.clear();
+	m_bounds = QRect();
+	m_filter.resetAnagramFilters();
+
+	GameCache::save(this);
 
 	emit generated();
 }
 
 //-----------------------------------------------------------------------------
 
+void Pattern::finish() {
+	QMutexLocker locker(&m_job_mutex);
+	m_running = false;
+	m_job_finished.wakeAll();
+}
+
+//-----------------------------------------------------------------------------
+
+void Pattern::addToGrid(Word* word) {
+	QList<QPoint> positions = word->positions();
+	for (int i = 0; i < positions.count(); ++i) {
+		const QPoint& pos = positions.at(i);
+		GridCell& cell = m_grid[gridKey(pos)];
+		cell.letter = word->at(i);
+		cell.words++;
+		m_bounds |= QRect(pos, pos);
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+void Pattern::removeFromGrid(Word* word) {
+	QList<QPoint> positions = word->positions();
+	foreach (const QPoint& pos, positions) {
+		QHash<qint64, GridCell>::iterator cell = m_grid.find(gridKey(pos));
+		if ((cell != m_grid.end()) && (--cell->words == 0)) {
+			m_grid.erase(cell);
+		}
+	}
+
+	// Shrink bounds to remaining words
+	m_bounds = QRect();
+	foreach (Word* placed, m_solution) {
+		positions = placed->positions();
+		foreach (const QPoint& pos, positions) {
+			m_bounds |= QRect(pos, pos);
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+void Pattern::removeLastWord() {
+	Word* word = m_solution.takeLast();
+	removeFromGrid(word);
+	m_filter.removeAnagramFilter(word->solutions().at(0));
+	delete word;
+}
+
+//-----------------------------------------------------------------------------
+
+void Pattern::restart() {
+	bool placed = !m_solution.isEmpty();
+	cleanUp();
+	if (placed) {
+		updateProgress();
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+void Pattern::updateProgress() {
+	QMutexLocker locker(&m_progress_mutex);
+	if (!m_incremental) {
+		return;
+	}
+
+	// Store cells of words placed so far for the board to read when it is ready
+	m_progress.clear();
+	foreach (Word* word, m_solution) {
+		m_progress.append(QRect(word->positions().first(), word->positions().last()));
+	}
+
+	// Only signal once until the board has read them, as words change far faster than it redraws
+	if (!m_progress_changed) {
+		m_progress_changed = true;
+		locker.unlock();
+		emit progressChanged();
+	}
+}
+
+//-----------------------------------------------------------------------------
+
 void Pattern::cleanUp() {
 	qDeleteAll(m_solution);
 	m_solution.clear();
-	m_words->resetAnagramFilters();
+	m_grid.clear();
+	m_bounds = QRect();
+	m_filter.resetAnagramFilters();
 	m_current = QPoint(0,0);
 }
 
 //-----------------------------------------------------------------------------
 
-Word* Pattern::addWord(int) {
+Word* Pattern::addWord(int, const CancelToken&) {
 	return 0;
 }
 
 //-----------------------------------------------------------------------------
 
-Word* ChainPattern::addWord(int step) {
+Word* ChainPattern::addWord(int step, const CancelToken& cancel) {
 	Word* result = 0;
 	switch (step) {
 		case 0:
-			result = addRandomWord(Qt::Vertical);
+			result = addRandomWord(Qt::Vertical, cancel);
 			break;
 		case 1:
-			result = addRandomWord(Qt::Horizontal);
+			result = addRandomWord(Qt::Horizontal, cancel);
 			m_current += QPoint(wordLength(), 0);
 			break;
 		case 2:
-			result = addRandomWord(Qt::Vertical);
+			result = addRandomWord(Qt::Vertical, cancel);
 			m_current += QPoint(-wordLength(), wordLength());
 			break;
 		case 3:
-			result = addRandomWord(Qt::Horizontal);
+			result = addRandomWord(Qt::Horizontal, cancel);
 			m_current += QPoint(wordLength() - 1, wordLength() / -2);
 			break;
 		case 4:
-			result = addRandomWord(Qt::Horizontal);
+			result = addRandomWord(Qt::Horizontal, cancel);
 			m_current = QPoint(m_current.x() + wordLength() - 1, 0);
 			break;
 		default:
@@ -229,30 +546,30 @@ Word* ChainPattern::addWord(int step) {
 
 //-----------------------------------------------------------------------------
 
-Word* FencePattern::addWord(int step) {
+Word* FencePattern::addWord(int step, const CancelToken& cancel) {
 	Word* result = 0;
 	switch (step) {
 		case 0:
-			result = addRandomWord(Qt::Vertical);
+			result = addRandomWord(Qt::Vertical, cancel);
 			m_current += QPoint(0, 1);
 			break;
 		case 1:
-			result = addRandomWord(Qt::Horizontal);
+			result = addRandomWord(Qt::Horizontal, cancel);
 			m_current += QPoint(0, 2);
 			break;
 		case 2:
-			result = addRandomWord(Qt::Horizontal);
+			result = addRandomWord(Qt::Horizontal, cancel);
 			m_current += QPoint(wordLength(), -3);
 			break;
 		case 3:
-			result = addRandomWord(Qt::Vertical);
+			result = addRandomWord(Qt::Vertical, cancel);
 			break;
 		case 4:
-			result = addRandomWord(Qt::Horizontal);
+			result = addRandomWord(Qt::Horizontal, cancel);
 			m_current += QPoint(0, 2);
 			break;
 		case 5:
-			result = addRandomWord(Qt::Horizontal);
+			result = addRandomWord(Qt::Horizontal, cancel);
 			m_current += QPoint(wordLength(),- 2);
 			break;
 		default:
@@ -263,22 +580,22 @@ Word* FencePattern::addWord(int step) {
 
 //-----------------------------------------------------------------------------
 
-Word* RingsPattern::addWord(int step) {
+Word* RingsPattern::addWord(int step, const CancelToken& cancel) {
 	Word* result = 0;
 	switch (step) {
 		case 0:
-			result = addRandomWord(Qt::Horizontal);
+			result = addRandomWord(Qt::Horizontal, cancel);
 			break;
 		case 1:
-			result = addRandomWord(Qt::Vertical);
+			result = addRandomWord(Qt::Vertical, cancel);
 			m_current += QPoint(0, wordLength());
 			break;
 		case 2:
-			result = addRandomWord(Qt::Horizontal);
+			result = addRandomWord(Qt::Horizontal, cancel);
 			m_current += QPoint(wordLength(), -wordLength());
 			break;
 		case 3:
-			result = addRandomWord(Qt::Vertical);
+			result = addRandomWord(Qt::Vertical, cancel);
 			m_current = QPoint(m_current.x() - 2, m_current.y() ? 0 : (wordLength() - 2));
 			break;
 		default:
@@ -289,15 +606,15 @@ Word* RingsPattern::addWord(int step) {
 
 //-----------------------------------------------------------------------------
 
-Word* StairsPattern::addWord(int step) {
+Word* StairsPattern::addWord(int step, const CancelToken& cancel) {
 	Word* result = 0;
 	switch (step) {
 		case 0:
-			result = addRandomWord(Qt::Horizontal);
+			result = addRandomWord(Qt::Horizontal, cancel);
 			m_current += QPoint(wordLength() - 1, 0);
 			break;
 		case 1:
-			result = addRandomWord(Qt::Vertical);
+			result = addRandomWord(Qt::Vertical, cancel);
 			m_current += QPoint(0, wordLength());
 			break;
 		default:
@@ -308,19 +625,19 @@ Word* StairsPattern::addWord(int step) {
 
 //-----------------------------------------------------------------------------
 
-Word* TwistyPattern::addWord(int step) {
-	return step ? stepTwo() : stepOne();
+Word* TwistyPattern::addWord(int step, const CancelToken& cancel) {
+	return step ? stepTwo(cancel) : stepOne(cancel);
 }
 
 //-----------------------------------------------------------------------------
 
-Word* TwistyPattern::stepOne() {
+Word* TwistyPattern::stepOne(const CancelToken& cancel) {
 	QList<QPoint> positions;
 	for (int i = 0; i <= wordLength(); ++i) {
 		positions.append(m_current + QPoint(0, i));
 	}
 
-	while (!positions.isEmpty()) {
+	while (!positions.isEmpty() && !cancel.isCancelled()) {
 		QPoint pos = positions.takeAt(randomInt(positions.count()));
 
 		// Define possible range for word
@@ -358,7 +675,7 @@ Word* TwistyPattern::stepOne() {
 			left += offset ? randomInt(offset) : 0;
 			right = left + wordLength();
 			m_current = QPoint(left, pos.y());
-			return addRandomWord(Qt::Horizontal);
+			return addRandomWord(Qt::Horizontal, cancel);
 		}
 	}
 
@@ -367,13 +684,13 @@ Word* TwistyPattern::stepOne() {
 
 //-----------------------------------------------------------------------------
 
-Word* TwistyPattern::stepTwo() {
+Word* TwistyPattern::stepTwo(const CancelToken& cancel) {
 	QList<QPoint> positions;
 	for (int i = 0; i <= wordLength(); ++i) {
 		positions.append(m_current + QPoint(i, 0));
 	}
 
-	while (!positions.isEmpty()) {
+	while (!positions.isEmpty() && !cancel.isCancelled()) {
 		QPoint pos = positions.takeAt(randomInt(positions.count()));
 
 		// Define possible range for word
@@ -411,7 +728,7 @@ Word* TwistyPattern::stepTwo() {
 			top += offset ? randomInt(offset) : 0;
 			bottom = top + wordLength();
 			m_current = QPoint(pos.x(), top);
-			return addRandomWord(Qt::Vertical);
+			return addRandomWord(Qt::Vertical, cancel);
 		}
 	}
 
@@ -420,23 +737,23 @@ Word* TwistyPattern::stepTwo() {
 
 //-----------------------------------------------------------------------------
 
-Word* WavePattern::addWord(int step) {
+Word* WavePattern::addWord(int step, const CancelToken& cancel) {
 	Word* result = 0;
 	switch (step) {
 		case 0:
-			result = addRandomWord(Qt::Horizontal);
+			result = addRandomWord(Qt::Horizontal, cancel);
 			m_current += QPoint(wordLength(), 0);
 			break;
 		case 1:
-			result = addRandomWord(Qt::Vertical);
+			result = addRandomWord(Qt::Vertical, cancel);
 			m_current += QPoint(0, wordLength());
 			break;
 		case 2:
-			result = addRandomWord(Qt::Horizontal);
+			result = addRandomWord(Qt::Horizontal, cancel);
 			m_current += QPoint(wordLength(), -wordLength());
 			break;
 		case 3:
-			result = addRandomWord(Qt::Vertical);
+			result = addRandomWord(Qt::Vertical, cancel);
 			break;
 		default:
 			break;
@@ -20,19 +20,25 @@
 #ifndef PATTERN_H
 #define PATTERN_H
 
+#include "cancel_token.h"
 #include "random.h"
 #include "wordlist.h"
 class Word;
 
+#include <QDataStream>
 #include <QHash>
 #include <QList>
 #include <QMutex>
+#include <QObject>
 #include <QPoint>
+#include <QRect>
 #include <QSize>
 #include <QStringList>
-#include <QThread>
+#include <QVector>
+#include <QWaitCondition>
+class QThreadPool;
 
-class Pattern : public QThread {
+class Pattern : public QObject {
 	Q_OBJECT
 
 	public:
@@ -52,6 +58,8 @@ class Pattern : public QThread {
 			return QList<int>() << 4 << 8 << 12 << 16;
 		}
 
+		bool isFeasible() const;
+
 		virtual QString name() const {
 			return QString();
 		}
@@ -72,6 +80,12 @@ class Pattern : public QThread {
 			return m_seed;
 		}
 
+		QString number() const;
+
+		int type() const {
+			return m_type;
+		}
+
 		const WordList* words() const {
 			return m_words;
 		}
@@ -84,19 +98,43 @@ class Pattern : public QThread {
 			return m_length;
 		}
 
+		int version() const {
+			return m_version;
+		}
+
+		static int currentVersion() {
+			return 4;
+		}
+
 		void setCount(int count);
+		void setIncremental(bool incremental);
 		void setLength(int length);
 		void setSeed(int seed);
+		void setVersion(int version);
+
+		QList<QRect> progress();
+
+		bool readSolution(QDataStream& stream);
+		void writeSolution(QDataStream& stream) const;
+
+		bool isRunning() const;
+		void cancel();
+		void start(int priority = 0);
+		void promote();
+		void wait();
+
+		static QThreadPool* pool();
 
 	signals:
 		void generated();
+		void failed();
+		void progressChanged();
 
 	protected:
 		Pattern(WordList* words);
 
-		Word* addRandomWord(Qt::Orientation orientation);
+		Word* addRandomWord(Qt::Orientation orientation, const CancelToken& cancel);
 		QChar at(const QPoint& pos) const;
-		virtual void run();
 
 		unsigned int randomInt(unsigned int max) {
 			return m_random.nextInt(max);
@@ -106,23 +144,60 @@ class Pattern : public QThread {
 		QPoint m_current;
 
 	private:
+		class Job;
+
+		void generate();
+		void finish();
+		void addToGrid(Word* word);
+		void removeFromGrid(Word* word);
+		void removeLastWord();
+		void restart();
 		void cleanUp();
+		void updateProgress();
+
+		virtual int crossings() const {
+			return 2;
+		}
 
 		virtual int steps() const {
 			return 2;
 		}
 
-		virtual Word* addWord(int step);
+		virtual Word* addWord(int step, const CancelToken& cancel);
+
+		static qint64 gridKey(const QPoint& pos) {
+			return (qint64(pos.x()) << 32) | quint32(pos.y());
+		}
 
 	private:
+		struct GridCell {
+			GridCell() : words(0) {
+			}
+
+			QChar letter;
+			int words;
+		};
+
 		WordList* m_words;
+		WordFilter m_filter;
 		int m_count;
 		int m_length;
 		int m_seed;
+		int m_type;
+		int m_version;
+		bool m_incremental;
+		QList<QRect> m_progress;
+		bool m_progress_changed;
+		mutable QMutex m_progress_mutex;
 		QSize m_size;
 		QList<Word*> m_solution;
-		bool m_cancelled;
-		QMutex m_cancelled_mutex;
+		QHash<qint64, GridCell> m_grid;
+		QRect m_bounds;
+		bool m_running;
+		Job* m_job;
+		CancelToken m_cancel;
+		mutable QMutex m_job_mutex;
+		QWaitCondition m_job_finished;
 		Random m_random;
 };
 
@@ -148,7 +223,7 @@ class ChainPattern : public Pattern {
 			return 5;
 		}
 
-		Word* addWord(int step);
+		Word* addWord(int step, const CancelToken& cancel);
 };
 
 //-----------------------------------------------------------------------------
@@ -173,7 +248,7 @@ class FencePattern : public Pattern {
 			return 6;
 		}
 
-		Word* addWord(int step);
+		Word* addWord(int step, const CancelToken& cancel);
 };
 
 //-----------------------------------------------------------------------------
@@ -198,7 +273,7 @@ class RingsPattern : public Pattern {
 			return 4;
 		}
 
-		Word* addWord(int step);
+		Word* addWord(int step, const CancelToken& cancel);
 };
 
 //-----------------------------------------------------------------------------
@@ -215,7 +290,7 @@ class StairsPattern : public Pattern {
 		}
 
 	private:
-		Word* addWord(int step);
+		Word* addWord(int step, const CancelToken& cancel);
 };
 
 //-----------------------------------------------------------------------------
@@ -232,9 +307,13 @@ class TwistyPattern : public Pattern {
 		}
 
 	private:
-		Word* addWord(int step);
-		Word* stepOne();
-		Word* stepTwo();
+		int crossings() const {
+			return 1;
+		}
+
+		Word* addWord(int step, const CancelToken& cancel);
+		Word* stepOne(const CancelToken& cancel);
+		Word* stepTwo(const CancelToken& cancel);
 };
 
 //-----------------------------------------------------------------------------
@@ -259,7 +338,7 @@ class WavePattern : public Pattern {
 			return 4;
 		}
 
-		Word* addWord(int step);
+		Word* addWord(int step, const CancelToken& cancel);
 };
 
 #endif
@@ -38,10 +38,13 @@ double Random::nextDouble() {
 //-----------------------------------------------------------------------------
 
 unsigned int Random::nextInt(unsigned int max) {
-	m_seed ^= (m_seed << 21);
-	m_seed ^= (m_seed >> 35);
-	m_seed ^= (m_seed << 4);
-	return m_seed % qMax(max, 1U);
+	return next() % qMax(max, 1U);
+}
+
+//-----------------------------------------------------------------------------
+
+quint64 Random::nextInt64(quint64 max) {
+	return next() % qMax(max, Q_UINT64_C(1));
 }
 
 //-----------------------------------------------------------------------------
@@ -51,3 +54,12 @@ void Random::setSeed(quint64 seed) {
 }
 
 //-----------------------------------------------------------------------------
+
+quint64 Random::next() {
+	m_seed ^= (m_seed << 21);
+	m_seed ^= (m_seed >> 35);
+	m_seed ^= (m_seed << 4);
+	return m_seed;
+}
+
+//-----------------------------------------------------------------------------
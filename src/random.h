@@ -28,6 +28,7 @@ public:
 
 	double nextDouble();
 	unsigned int nextInt(unsigned int max = maximum);
+	quint64 nextInt64(quint64 max);
 	void setSeed(quint64 seed);
 
 	unsigned int operator()(unsigned int max) {
@@ -36,6 +37,9 @@ public:
 
 	static const unsigned int maximum;
 
+private:
+	quint64 next();
+
 private:
 	quint64 m_seed;
 };
@@ -44,6 +44,7 @@ Window::Window() {
 	m_board = new Board(this);
 	connect(m_board, SIGNAL(finished()), this, SLOT(gameFinished()));
 	connect(m_board, SIGNAL(started()), this, SLOT(gameStarted()));
+	connect(m_board, SIGNAL(failed()), this, SLOT(gameFailed()));
 	connect(m_board, SIGNAL(pauseChanged()), this, SLOT(gamePauseChanged()));
 
 	QWidget* contents = new QWidget(this);
@@ -183,7 +184,8 @@ Window::Window() {
 
 	// Continue previous or start new game
 	show();
-	if (settings.contains("Current/Words") && (settings.value("Current/Version" ).toInt() == 3)) {
+	int version = settings.value("Current/Version").toInt();
+	if (settings.contains("Current/Words") && (version >= 3) && (version <= Pattern::currentVersion())) {
 		m_board->openGame();
 	} else {
 		settings.remove("Current");
@@ -262,17 +264,10 @@ void Window::showDetails() {
 	if (!pattern) {
 		return;
 	}
-	QString patternid = QSettings().value("Current/Pattern", 0).toString();
 	static const QStringList sizes = QStringList() << NewGameDialog::tr("Low")
 		<< NewGameDialog::tr("Medium")
 		<< NewGameDialog::tr("High")
 		<< NewGameDialog::tr("Very High");
-	QString number = "3"
-		+ m_board->words()->language()
-		+ patternid
-		+ QString::number(pattern->wordCount())
-		+ QString("%1").arg(int(pattern->wordLength() - 4), 2, 16, QLatin1Char('0'))
-		+ QString::number(pattern->seed(), 16);
 	QMessageBox dialog(QMessageBox::Information,
 		tr("Details"),
 		QString("<p><b>%1</b> %2<br><b>%3</b> %4<br><b>%5</b> %6<br><b>%7</b> %8<br><b>%9</b> %10</p>")
@@ -280,10 +275,10 @@ void Window::showDetails() {
 			.arg(NewGameDialog::tr("Language:")).arg(LocaleDialog::languageName(m_board->words()->language()))
 			.arg(NewGameDialog::tr("Amount of Words:")).arg(sizes.value(pattern->wordCount()))
 			.arg(NewGameDialog::tr("Word Length:")).arg(NewGameDialog::tr("%n letter(s)", "", pattern->wordLength() + 1))
-			.arg(tr("Game Number:")).arg(number),
+			.arg(tr("Game Number:")).arg(pattern->number()),
 		QMessageBox::NoButton,
 		this);
-	dialog.setIconPixmap(QString(":/patterns/%1.png").arg(patternid));
+	dialog.setIconPixmap(QString(":/patterns/%1.png").arg(pattern->type()));
 	dialog.exec();
 }
 
@@ -305,6 +300,14 @@ void Window::gameStarted() {
 
 //-----------------------------------------------------------------------------
 
+void Window::gameFailed() {
+	QSettings().remove("Current");
+	QMessageBox::warning(this, tr("Sorry"), tr("Unable to create a game with these settings. Please try fewer or shorter words, or a different pattern."));
+	newGame();
+}
+
+//-----------------------------------------------------------------------------
+
 void Window::gameFinished() {
 	QSettings settings;
 	int count = settings.value("Current/Count").toInt();
@@ -48,6 +48,7 @@ class Window : public QMainWindow {
 		void showDetails();
 		void setLocale();
 		void gameStarted();
+		void gameFailed();
 		void gameFinished();
 		void gamePauseChanged();
 
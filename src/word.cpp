@@ -19,50 +19,81 @@
 
 #include "word.h"
 
-#include "board.h"
-#include "cell.h"
-#include "letter.h"
 #include "random.h"
 #include "wordlist.h"
 
-#include <QGraphicsPathItem>
-#include <QHash>
-#include <QPainterPath>
+#include <QVector>
 
 #include <algorithm>
 
-static int factorial(int num) {
-	return (num > 1) ? (factorial(num - 1) * num) : 1;
+// Amount of distinct arrangements of letters, or 0 if it does not fit in 64 bits
+static quint64 countPermutations(const QVector<int>& counts) {
+	quint64 result = 1;
+	quint64 n = 0;
+	foreach (int k, counts) {
+		// Multiply by binomial coefficient of n + k choose k, one factor at a time
+		for (quint64 j = 1; j <= quint64(k); ++j) {
+			++n;
+			quint64 a = result;
+			quint64 b = j;
+			while (b) {
+				quint64 t = a % b;
+				a = b;
+				b = t;
+			}
+			quint64 factor = n / (j / a);
+			result /= a;
+			if (result > (Q_UINT64_C(0xFFFFFFFFFFFFFFFF) / factor)) {
+				return 0;
+			}
+			result *= factor;
+		}
+	}
+	return result;
 }
 
-static int countPermutations(const QString& word) {
-	Q_ASSERT(!word.isEmpty());
-
-	int n = factorial(word.length());
-	int d = 1;
-
-	QString sorted = word;
-	std::sort(sorted.begin(), sorted.end());
-	QChar c;
-	int count = 0;
-	foreach (const QChar& c2, sorted) {
-		if (c2 != c) {
-			c = c2;
-			d *= factorial(count);
-			count = 1;
-		} else {
-			count++;
+// Position of word in sorted order of every arrangement of letters
+static quint64 rankPermutation(const QString& letters, QVector<int> counts, const QString& word) {
+	quint64 rank = 0;
+	foreach (const QChar& c, word) {
+		int index = letters.indexOf(c);
+		for (int i = 0; i < index; ++i) {
+			if (counts[i] > 0) {
+				counts[i]--;
+				rank += countPermutations(counts);
+				counts[i]++;
+			}
 		}
+		counts[index]--;
 	}
-	d *= factorial(count);
+	return rank;
+}
 
-	return n / d;
+// Arrangement of letters at rank in sorted order
+static QString unrankPermutation(const QString& letters, QVector<int> counts, quint64 rank, int length) {
+	QString result;
+	for (int n = 0; n < length; ++n) {
+		for (int i = 0; i < counts.count(); ++i) {
+			if (counts[i] == 0) {
+				continue;
+			}
+			counts[i]--;
+			quint64 count = countPermutations(counts);
+			if (rank < count) {
+				result.append(letters.at(i));
+				break;
+			}
+			rank -= count;
+			counts[i]++;
+		}
+	}
+	return result;
 }
 
 //-----------------------------------------------------------------------------
 
-Word::Word(const QString& word, const QPoint& position, Qt::Orientation orientation, Random& random)
-: m_board(0), m_correct(false), m_orientation(orientation), m_random(random) {
+Word::Word(const QString& word, const QPoint& position, Qt::Orientation orientation, const Alphabet& alphabet, Random& random)
+: m_board(0), m_correct(false), m_orientation(orientation), m_alphabet(alphabet), m_random(random) {
 	if (word.isEmpty()) {
 		return;
 	}
@@ -78,102 +109,6 @@ Word::Word(const QString& word, const QPoint& position, Qt::Orientation orientat
 
 //-----------------------------------------------------------------------------
 
-void Word::click() {
-	m_board->click(toString());
-}
-
-//-----------------------------------------------------------------------------
-
-void Word::check() {
-	QString word;
-	foreach (const QPoint& pos, m_positions) {
-		word += m_board->cell(pos.x(), pos.y())->letter()->character();
-	}
-	if (m_solutions.contains(word)) {
-		m_correct = true;
-		foreach (const QPoint& pos, m_positions) {
-			Cell* cell = m_board->cell(pos.x(), pos.y());
-			cell->setWord(this);
-			cell->letter()->setCorrect();
-		}
-		m_board->setCurrentWord(0);
-		m_board->check(m_solutions.at(0), word);
-	}
-}
-
-//-----------------------------------------------------------------------------
-
-QGraphicsItem* Word::hint() {
-	if (isCorrect()) {
-		return 0;
-	}
-
-	// Find position of first incorrect character
-	int count = m_positions.count();
-	int pos = -1;
-	QString solution;
-	foreach (const QString& word, m_solutions) {
-		for (int i = 0; i < count; ++i) {
-			const QPoint& point = m_positions.at(i);
-			Letter* letter = m_board->cell(point.x(), point.y())->letter();
-			if (letter->character() != word.at(i)) {
-				if (i > pos) {
-					pos = i;
-					solution = word;
-				}
-				break;
-			}
-		}
-	}
-
-	// Find letter from end of string which goes in that position
-	QChar c = solution.at(pos);
-	int pos2;
-	QPointF position;
-	for (pos2 = count - 1; pos2 > pos; --pos2) {
-		const QPoint& point = m_positions.at(pos2);
-		Letter* letter = m_board->cell(point.x(), point.y())->letter();
-		if (letter->isMovable() && letter->character() == c) {
-			position = letter->scenePos();
-			letter->setBrush(QColor("#ffbf00"));
-			break;
-		}
-	}
-
-	// Create hint graphicsitem
-	int edge = ((pos2 - pos - 1) * 34) + 16;
-	QList<QPointF> positions;
-	positions += QPointF(0, 8);
-	positions += QPointF(12, 0);
-	positions += QPointF(12, 5);
-	positions += QPointF(edge, 5);
-	positions += QPointF(edge, 11);
-	positions += QPointF(12, 11);
-	positions += QPointF(12, 16);
-	positions += QPointF(0, 8);
-	QPointF delta = QPointF(-edge, 8);
-	if (m_orientation == Qt::Vertical) {
-		delta = QPointF(8, -edge);
-		for (int i = 0; i < 8; ++i) {
-			QPointF& pos = positions[i];
-			qSwap(pos.rx(), pos.ry());
-		}
-	}
-	QPainterPath path;
-	path.moveTo(positions.at(0));
-	for (int i = 1; i < 8; ++i) {
-		path.lineTo(positions.at(i));
-	}
-
-	QGraphicsPathItem* item = m_board->addPath(path, Qt::NoPen, QColor("#ffbf00"));
-	item->setPos(position + delta);
-	item->setZValue(20);
-
-	return item;
-}
-
-//-----------------------------------------------------------------------------
-
 void Word::moveBy(const QPoint& delta) {
 	int count = m_positions.count();
 	for (int i = 0; i < count; ++i) {
@@ -183,116 +118,97 @@ void Word::moveBy(const QPoint& delta) {
 
 //-----------------------------------------------------------------------------
 
-void Word::fromString(const QString& shuffled) {
-	// Find movable letters
-	QString sorted1;
-	QList<Letter*> letters;
-	for (int i = 0; i < m_positions.count(); ++i) {
-		const QPoint& pos = m_positions.at(i);
-		Letter* letter = m_board->cell(pos.x(), pos.y())->letter();
-		QChar c = letter->character();
-		sorted1.append(c);
-		if (letter->isMovable()) {
-			letters.append(letter);
-		} else if (c != shuffled.at(i)) {
-			return;
-		}
-	}
-
-	// Check if shuffled has the right characters
-	QString sorted2 = shuffled;
-	std::sort(sorted1.begin(), sorted1.end());
-	std::sort(sorted2.begin(), sorted2.end());
-	if (sorted1 != sorted2) {
-		return;
-	}
-
-	// Move letters to match shuffled
-	for (int i = 0; i < m_positions.count(); ++i) {
-		const QPoint& pos = m_positions.at(i);
-		Cell* cell = m_board->cell(pos.x(), pos.y());
-		if (!cell->letter()->isMovable()) {
-			continue;
-		}
-
-		QChar c = shuffled.at(i);
-		for (int j = 0; j < letters.count(); ++j) {
-			if (letters.at(j)->character() == c) {
-				cell->setLetter(letters.takeAt(j));
-				break;
-			}
+bool Word::restore(const QStringList& solutions, const QString& scrambled) {
+	// Only accept solutions and scrambled letters that match this word
+	LetterCounts letters(m_alphabet, m_solutions.value(0));
+	QStringList words = solutions;
+	words.append(scrambled);
+	foreach (const QString& word, words) {
+		LetterCounts counts(m_alphabet, word);
+		if (!counts.isValid() || (counts != letters)) {
+			return false;
 		}
 	}
 
-	check();
-}
-
-//-----------------------------------------------------------------------------
-
-QString Word::toString() const {
-	QString result;
-	foreach (const QPoint& pos, m_positions) {
-		result.append(m_board->cell(pos.x(), pos.y())->letter()->character());
-	}
-	return result;
-}
-
-//-----------------------------------------------------------------------------
-
-void Word::setHighlight(bool highlight) {
-	foreach (const QPoint& pos, m_positions) {
-		m_board->cell(pos.x(), pos.y())->letter()->setHighlight(highlight);
-	}
+	m_solutions = solutions;
+	m_scrambled = scrambled;
+	return true;
 }
 
 //-----------------------------------------------------------------------------
 
-void Word::shuffle(const WordList* words) {
-	// Create list of characters and filter the list of words
-	QHash<int, QChar> fixed;
-	QString chars;
+void Word::shuffle(const WordBucket* words, const QString& known_letters) {
+	// Find letters that can be moved and how often each occurs
+	QString chars = m_solutions.at(0);
 	QString movable;
-	QString filter;
-	for (int i = 0; i < m_positions.count(); ++i) {
-		const QPoint& pos = m_positions.at(i);
-		Letter* letter = m_board->cell(pos.x(), pos.y())->letter();
-		QChar c = letter->character();
-		chars.append(c);
-		if (letter->isMovable()) {
-			movable.append(c);
-			filter.append('.');
-		} else {
-			filter.append(c);
-			fixed.insert(i, c);
+	for (int i = 0; i < chars.length(); ++i) {
+		if (known_letters.at(i) == QLatin1Char('.')) {
+			movable.append(chars.at(i));
+		}
+	}
+	LetterCounts histogram(m_alphabet, movable);
+	QString letters;
+	QVector<int> counts;
+	for (int i = 0, size = m_alphabet.count(); i < size; ++i) {
+		int count = histogram.count(i);
+		if (count > 0) {
+			letters.append(m_alphabet.letter(i));
+			counts.append(count);
 		}
 	}
-	std::sort(chars.begin(), chars.end());
-	std::sort(movable.begin(), movable.end());
-	QStringList filtered = words->filter(filter);
 
 	// Find valid solutions
-	foreach (const QString& valid, filtered) {
-		QString sorted = valid;
-		std::sort(sorted.begin(), sorted.end());
-		if (sorted == chars && !m_solutions.contains(valid)) {
+	QStringList anagrams = words->anagrams(chars, known_letters);
+	foreach (const QString& valid, anagrams) {
+		if (!m_solutions.contains(valid)) {
 			m_solutions.append(valid);
 		}
 	}
 
-	// Find permutation
-	QString permuted;
-	if (m_solutions.count() < countPermutations(movable)) {
+	// Find movable letters of each solution
+	QStringList moved;
+	foreach (const QString& solution, m_solutions) {
+		QString letters_moved;
+		for (int i = 0; i < solution.length(); ++i) {
+			if (known_letters.at(i) == QLatin1Char('.')) {
+				letters_moved.append(solution.at(i));
+			}
+		}
+		moved.append(letters_moved);
+	}
+
+	// Pick random arrangement that is not a solution
+	QString permuted = movable;
+	quint64 total = countPermutations(counts);
+	if (total == 0) {
+		// Too many arrangements to count, so a solution is almost never picked
 		do {
-			std::random_shuffle(movable.begin(), movable.end(), m_random);
-			permuted = movable;
-			QHashIterator<int, QChar> j(fixed);
-			while (j.hasNext()) {
-				j.next();
-				permuted.insert(j.key(), j.value());
+			std::random_shuffle(permuted.begin(), permuted.end(), m_random);
+		} while (moved.contains(permuted));
+	} else if (quint64(moved.count()) < total) {
+		// Skip over ranks of solutions while picking from the rest
+		QList<quint64> solutions;
+		foreach (const QString& solution, moved) {
+			solutions.append(rankPermutation(letters, counts, solution));
+		}
+		std::sort(solutions.begin(), solutions.end());
+		solutions.erase(std::unique(solutions.begin(), solutions.end()), solutions.end());
+
+		quint64 rank = m_random.nextInt64(total - solutions.count());
+		foreach (quint64 solution, solutions) {
+			if (solution <= rank) {
+				++rank;
 			}
-		} while (m_solutions.contains(permuted));
+		}
+		permuted = unrankPermutation(letters, counts, rank, movable.length());
 	} else {
-		permuted = m_solutions.at(0);
+		m_scrambled = m_solutions.at(0);
+		return;
+	}
+
+	// Put crossed letters back into place
+	m_scrambled.clear();
+	for (int i = 0, j = 0; i < chars.length(); ++i) {
+		m_scrambled.append((known_letters.at(i) == QLatin1Char('.')) ? permuted.at(j++) : chars.at(i));
 	}
-	fromString(permuted);
 }
@@ -20,18 +20,21 @@
 #ifndef WORD_H
 #define WORD_H
 
+#include "alphabet.h"
+
 #include <QChar>
 #include <QList>
 #include <QPoint>
 #include <QString>
+#include <QStringList>
 class QGraphicsItem;
 class Board;
 class Random;
-class WordList;
+class WordBucket;
 
 class Word {
 	public:
-		Word(const QString& word, const QPoint& position, Qt::Orientation orientation, Random& random);
+		Word(const QString& word, const QPoint& position, Qt::Orientation orientation, const Alphabet& alphabet, Random& random);
 
 		QChar at(int i) const {
 			return m_solutions.at(0).at(i);
@@ -58,6 +61,11 @@ class Word {
 		}
 
 		void moveBy(const QPoint& delta);
+		bool restore(const QStringList& solutions, const QString& scrambled);
+
+		QString scrambled() const {
+			return m_scrambled;
+		}
 
 		void fromString(const QString& shuffled);
 		QString toString() const;
@@ -67,14 +75,16 @@ class Word {
 		}
 
 		void setHighlight(bool highlight);
-		void shuffle(const WordList* words);
+		void shuffle(const WordBucket* words, const QString& known_letters);
 
 	private:
 		Board* m_board;
 		bool m_correct;
 		QList<QPoint> m_positions;
 		QList<QString> m_solutions;
+		QString m_scrambled;
 		Qt::Orientation m_orientation;
+		Alphabet m_alphabet;
 		Random& m_random;
 };
 
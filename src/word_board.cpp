@@ -0,0 +1,185 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2009, 2013 Graeme Gott <graeme@gottcode.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#include "word.h"
+
+#include "board.h"
+#include "cell.h"
+#include "letter.h"
+
+#include <QGraphicsPathItem>
+#include <QPainterPath>
+
+//-----------------------------------------------------------------------------
+
+void Word::click() {
+	m_board->click(toString());
+}
+
+//-----------------------------------------------------------------------------
+
+void Word::check() {
+	QString word;
+	foreach (const QPoint& pos, m_positions) {
+		word += m_board->cell(pos.x(), pos.y())->letter()->character();
+	}
+	if (m_solutions.contains(word)) {
+		m_correct = true;
+		foreach (const QPoint& pos, m_positions) {
+			Cell* cell = m_board->cell(pos.x(), pos.y());
+			cell->setWord(this);
+			cell->letter()->setCorrect();
+		}
+		m_board->setCurrentWord(0);
+		m_board->check(m_solutions.at(0), word);
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+QGraphicsItem* Word::hint() {
+	if (isCorrect()) {
+		return 0;
+	}
+
+	// Find position of first incorrect character
+	int count = m_positions.count();
+	int pos = -1;
+	QString solution;
+	foreach (const QString& word, m_solutions) {
+		for (int i = 0; i < count; ++i) {
+			const QPoint& point = m_positions.at(i);
+			Letter* letter = m_board->cell(point.x(), point.y())->letter();
+			if (letter->character() != word.at(i)) {
+				if (i > pos) {
+					pos = i;
+					solution = word;
+				}
+				break;
+			}
+		}
+	}
+
+	// Find letter from end of string which goes in that position
+	QChar c = solution.at(pos);
+	int pos2;
+	QPointF position;
+	for (pos2 = count - 1; pos2 > pos; --pos2) {
+		const QPoint& point = m_positions.at(pos2);
+		Letter* letter = m_board->cell(point.x(), point.y())->letter();
+		if (letter->isMovable() && letter->character() == c) {
+			position = letter->scenePos();
+			letter->setBrush(QColor("#ffbf00"));
+			break;
+		}
+	}
+
+	// Create hint graphicsitem
+	int edge = ((pos2 - pos - 1) * 34) + 16;
+	QList<QPointF> positions;
+	positions += QPointF(0, 8);
+	positions += QPointF(12, 0);
+	positions += QPointF(12, 5);
+	positions += QPointF(edge, 5);
+	positions += QPointF(edge, 11);
+	positions += QPointF(12, 11);
+	positions += QPointF(12, 16);
+	positions += QPointF(0, 8);
+	QPointF delta = QPointF(-edge, 8);
+	if (m_orientation == Qt::Vertical) {
+		delta = QPointF(8, -edge);
+		for (int i = 0; i < 8; ++i) {
+			QPointF& pos = positions[i];
+			qSwap(pos.rx(), pos.ry());
+		}
+	}
+	QPainterPath path;
+	path.moveTo(positions.at(0));
+	for (int i = 1; i < 8; ++i) {
+		path.lineTo(positions.at(i));
+	}
+
+	QGraphicsPathItem* item = m_board->addPath(path, Qt::NoPen, QColor("#ffbf00"));
+	item->setPos(position + delta);
+	item->setZValue(20);
+
+	return item;
+}
+
+//-----------------------------------------------------------------------------
+
+void Word::fromString(const QString& shuffled) {
+	// Find movable letters
+	QString current;
+	QList<Letter*> letters;
+	for (int i = 0; i < m_positions.count(); ++i) {
+		const QPoint& pos = m_positions.at(i);
+		Letter* letter = m_board->cell(pos.x(), pos.y())->letter();
+		QChar c = letter->character();
+		current.append(c);
+		if (letter->isMovable()) {
+			letters.append(letter);
+		} else if (c != shuffled.at(i)) {
+			return;
+		}
+	}
+
+	// Check if shuffled has the right characters
+	LetterCounts counts(m_alphabet, shuffled);
+	if (!counts.isValid() || (counts != LetterCounts(m_alphabet, current))) {
+		return;
+	}
+
+	// Move letters to match shuffled
+	for (int i = 0; i < m_positions.count(); ++i) {
+		const QPoint& pos = m_positions.at(i);
+		Cell* cell = m_board->cell(pos.x(), pos.y());
+		if (!cell->letter()->isMovable()) {
+			continue;
+		}
+
+		QChar c = shuffled.at(i);
+		for (int j = 0; j < letters.count(); ++j) {
+			if (letters.at(j)->character() == c) {
+				cell->setLetter(letters.takeAt(j));
+				break;
+			}
+		}
+	}
+
+	check();
+}
+
+//-----------------------------------------------------------------------------
+
+QString Word::toString() const {
+	QString result;
+	foreach (const QPoint& pos, m_positions) {
+		result.append(m_board->cell(pos.x(), pos.y())->letter()->character());
+	}
+	return result;
+}
+
+//-----------------------------------------------------------------------------
+
+void Word::setHighlight(bool highlight) {
+	foreach (const QPoint& pos, m_positions) {
+		m_board->cell(pos.x(), pos.y())->letter()->setHighlight(highlight);
+	}
+}
@@ -0,0 +1,332 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2013 Graeme Gott <graeme@gottcode.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#include "word_dawg.h"
+
+#include <QHash>
+
+typedef QVector<QPair<uchar, int> > BuildEdges;
+
+//-----------------------------------------------------------------------------
+
+// Merge nodes below depth with identical nodes found earlier
+static void minimize(QVector<BuildEdges>& edges, QHash<QByteArray, int>& registry, const QVector<int>& path, int depth, int length) {
+	for (int d = length - 1; d >= depth; --d) {
+		int child = path.at(d + 1);
+		QByteArray signature;
+		foreach (const BuildEdges::value_type& edge, edges.at(child)) {
+			signature.append(char(edge.first));
+			signature.append(reinterpret_cast<const char*>(&edge.second), sizeof(edge.second));
+		}
+		int existing = registry.value(signature, -1);
+		if (existing != -1) {
+			edges[path.at(d)].last().second = existing;
+			edges[child].clear();
+		} else {
+			registry.insert(signature, child);
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+// Number nodes so that children come before their parents
+static int renumber(int node, const QVector<BuildEdges>& edges, QVector<int>& ids, QVector<int>& order) {
+	if (ids.at(node) == -1) {
+		foreach (const BuildEdges::value_type& edge, edges.at(node)) {
+			renumber(edge.second, edges, ids, order);
+		}
+		ids[node] = order.count();
+		order.append(node);
+	}
+	return ids.at(node);
+}
+
+//-----------------------------------------------------------------------------
+
+WordDawg::WordDawg()
+: m_length(0) {
+}
+
+//-----------------------------------------------------------------------------
+
+WordDawg WordDawg::create(const QByteArray& letters, int length) {
+	WordDawg dawg;
+	dawg.m_length = length;
+	int count = (length > 0) ? (letters.size() / length) : 0;
+	if (count == 0) {
+		return dawg;
+	}
+
+	// Add sorted words one at a time, merging the end of the previous word
+	// with identical nodes once the new word stops sharing it
+	QVector<BuildEdges> edges(1);
+	QHash<QByteArray, int> registry;
+	QVector<int> path(length + 1, 0);
+	const char* previous = 0;
+	for (int i = 0; i < count; ++i) {
+		const char* word = letters.constData() + (i * length);
+		int common = 0;
+		if (previous) {
+			while ((common < length) && (word[common] == previous[common])) {
+				++common;
+			}
+			if (common == length) {
+				continue;
+			}
+			minimize(edges, registry, path, common, length);
+		}
+		for (int d = common; d < length; ++d) {
+			int node = edges.count();
+			edges.append(BuildEdges());
+			edges[path.at(d)].append(qMakePair(uchar(word[d]), node));
+			path[d + 1] = node;
+		}
+		previous = word;
+	}
+	minimize(edges, registry, path, 0, length);
+
+	// Store reachable nodes compactly and count words below each
+	QVector<int> ids(edges.count(), -1);
+	QVector<int> order;
+	renumber(0, edges, ids, order);
+	int nodes = order.count();
+	dawg.m_node_edges.resize(nodes + 1);
+	dawg.m_node_counts.resize(nodes);
+	for (int i = 0; i < nodes; ++i) {
+		const BuildEdges& node = edges.at(order.at(i));
+		dawg.m_node_edges[i] = dawg.m_edge_targets.count();
+		quint32 words = node.isEmpty() ? 1 : 0;
+		foreach (const BuildEdges::value_type& edge, node) {
+			int target = ids.at(edge.second);
+			dawg.m_edge_codes.append(char(edge.first));
+			dawg.m_edge_targets.append(target);
+			words += dawg.m_node_counts.at(target);
+		}
+		dawg.m_node_counts[i] = words;
+	}
+	dawg.m_node_edges[nodes] = dawg.m_edge_targets.count();
+	return dawg;
+}
+
+//-----------------------------------------------------------------------------
+
+int WordDawg::count(const QVector<int>& pattern, Memo& memo) const {
+	if (isEmpty() || (pattern.count() != m_length)) {
+		return 0;
+	}
+	begin(pattern, memo);
+	return countBelow(m_node_counts.count() - 1, 0, pattern, wildFrom(pattern), memo);
+}
+
+//-----------------------------------------------------------------------------
+
+void WordDawg::ranges(const QVector<int>& pattern, QVector<QPair<int, int> >& ranges, Memo& memo) const {
+	if (!isEmpty() && (pattern.count() == m_length)) {
+		begin(pattern, memo);
+		rangesBelow(m_node_counts.count() - 1, 0, 0, pattern, wildFrom(pattern), ranges, memo);
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+int WordDawg::select(const QVector<int>& pattern, int k, Memo& memo) const {
+	if (isEmpty() || (pattern.count() != m_length) || (k < 0)) {
+		return -1;
+	}
+	begin(pattern, memo);
+
+	// Skip subtrees with fewer matches than remain of k
+	int wild_from = wildFrom(pattern);
+	int node = m_node_counts.count() - 1;
+	int rank = 0;
+	for (int depth = 0; depth < wild_from; ++depth) {
+		int code = pattern.at(depth);
+		int next = -1;
+		for (quint32 e = m_node_edges.at(node), end = m_node_edges.at(node + 1); e < end; ++e) {
+			int target = m_edge_targets.at(e);
+			int edge_code = uchar(m_edge_codes.at(e));
+			if ((code == -1) || (code == edge_code)) {
+				int matches = countBelow(target, depth + 1, pattern, wild_from, memo);
+				if (k < matches) {
+					next = target;
+					break;
+				}
+				k -= matches;
+			} else if (edge_code > code) {
+				break;
+			}
+			rank += m_node_counts.at(target);
+		}
+		if (next == -1) {
+			return -1;
+		}
+		node = next;
+	}
+	return (k < int(m_node_counts.at(node))) ? (rank + k) : -1;
+}
+
+//-----------------------------------------------------------------------------
+
+bool WordDawg::matches(int rank, const QVector<int>& pattern) const {
+	if (isEmpty() || (rank < 0) || (rank >= count()) || (pattern.count() != m_length)) {
+		return false;
+	}
+
+	// Follow the path of the word, comparing letters along the way
+	int node = m_node_counts.count() - 1;
+	for (int depth = 0; depth < m_length; ++depth) {
+		for (quint32 e = m_node_edges.at(node), end = m_node_edges.at(node + 1); e < end; ++e) {
+			int target = m_edge_targets.at(e);
+			int words = m_node_counts.at(target);
+			if (rank < words) {
+				if ((pattern.at(depth) != -1) && (pattern.at(depth) != uchar(m_edge_codes.at(e)))) {
+					return false;
+				}
+				node = target;
+				break;
+			}
+			rank -= words;
+		}
+	}
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+
+QByteArray WordDawg::word(int rank) const {
+	QByteArray result;
+	if (isEmpty() || (rank < 0) || (rank >= count())) {
+		return result;
+	}
+
+	int node = m_node_counts.count() - 1;
+	for (int depth = 0; depth < m_length; ++depth) {
+		for (quint32 e = m_node_edges.at(node), end = m_node_edges.at(node + 1); e < end; ++e) {
+			int target = m_edge_targets.at(e);
+			int words = m_node_counts.at(target);
+			if (rank < words) {
+				result.append(m_edge_codes.at(e));
+				node = target;
+				break;
+			}
+			rank -= words;
+		}
+	}
+	return result;
+}
+
+//-----------------------------------------------------------------------------
+
+int WordDawg::memoryUsage() const {
+	return (m_node_edges.count() + m_node_counts.count() + m_edge_targets.count()) * sizeof(quint32) + m_edge_codes.size();
+}
+
+//-----------------------------------------------------------------------------
+
+void WordDawg::begin(const QVector<int>& pattern, Memo& memo) const {
+	// Keep counts while searching for the same pattern again
+	int nodes = m_node_counts.count();
+	if ((memo.m_dawg == this) && (memo.m_queries.count() == nodes) && (memo.m_pattern == pattern)) {
+		return;
+	}
+
+	// Forget counts by moving to a new query number instead of clearing them
+	if ((memo.m_dawg != this) || (memo.m_queries.count() != nodes)) {
+		memo.m_dawg = this;
+		memo.m_queries.fill(0, nodes);
+		memo.m_counts.resize(nodes);
+		memo.m_query = 0;
+	}
+	if (++memo.m_query == 0) {
+		memo.m_queries.fill(0);
+		memo.m_query = 1;
+	}
+	memo.m_pattern.resize(pattern.count());
+	for (int i = 0; i < pattern.count(); ++i) {
+		memo.m_pattern[i] = pattern.at(i);
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+int WordDawg::countBelow(int node, int depth, const QVector<int>& pattern, int wild_from, Memo& memo) const {
+	if (depth >= wild_from) {
+		return m_node_counts.at(node);
+	}
+
+	// Every path to a node has the same length, so its count only depends on the pattern
+	if (memo.m_queries.at(node) == memo.m_query) {
+		return memo.m_counts.at(node);
+	}
+
+	int code = pattern.at(depth);
+	int result = 0;
+	for (quint32 e = m_node_edges.at(node), end = m_node_edges.at(node + 1); e < end; ++e) {
+		int edge_code = uchar(m_edge_codes.at(e));
+		if (code == -1) {
+			result += countBelow(m_edge_targets.at(e), depth + 1, pattern, wild_from, memo);
+		} else if (code == edge_code) {
+			result = countBelow(m_edge_targets.at(e), depth + 1, pattern, wild_from, memo);
+			break;
+		} else if (edge_code > code) {
+			break;
+		}
+	}
+	memo.m_queries[node] = memo.m_query;
+	memo.m_counts[node] = result;
+	return result;
+}
+
+//-----------------------------------------------------------------------------
+
+void WordDawg::rangesBelow(int node, int depth, int rank, const QVector<int>& pattern, int wild_from, QVector<QPair<int, int> >& ranges, Memo& memo) const {
+	if (depth >= wild_from) {
+		// Every word below matches; extend previous range if they are next to each other
+		int end = rank + m_node_counts.at(node);
+		if (!ranges.isEmpty() && (ranges.last().second == rank)) {
+			ranges.last().second = end;
+		} else {
+			ranges.append(qMakePair(rank, end));
+		}
+		return;
+	}
+
+	int code = pattern.at(depth);
+	for (quint32 e = m_node_edges.at(node), end = m_node_edges.at(node + 1); e < end; ++e) {
+		int target = m_edge_targets.at(e);
+		int edge_code = uchar(m_edge_codes.at(e));
+		if (((code == -1) || (code == edge_code)) && countBelow(target, depth + 1, pattern, wild_from, memo)) {
+			rangesBelow(target, depth + 1, rank, pattern, wild_from, ranges, memo);
+		} else if ((code != -1) && (edge_code > code)) {
+			break;
+		}
+		rank += m_node_counts.at(target);
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+int WordDawg::wildFrom(const QVector<int>& pattern) {
+	int result = pattern.count();
+	while ((result > 0) && (pattern.at(result - 1) == -1)) {
+		--result;
+	}
+	return result;
+}
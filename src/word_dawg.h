@@ -0,0 +1,81 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2013 Graeme Gott <graeme@gottcode.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef WORD_DAWG_H
+#define WORD_DAWG_H
+
+#include <QByteArray>
+#include <QPair>
+#include <QVector>
+
+// Minimized graph of words of one length that shares both prefixes and
+// suffixes; each node knows how many words are below it so that words
+// can be ranked, counted and picked without visiting every word
+class WordDawg {
+public:
+	// Matches below each node for the last pattern searched, so that a
+	// node shared by many paths is only counted once
+	class Memo {
+	public:
+		Memo() : m_dawg(0), m_query(0) {
+		}
+
+	private:
+		friend class WordDawg;
+		const WordDawg* m_dawg;
+		QVector<int> m_pattern;
+		QVector<quint32> m_queries;
+		QVector<int> m_counts;
+		quint32 m_query;
+	};
+
+	WordDawg();
+
+	static WordDawg create(const QByteArray& letters, int length);
+
+	bool isEmpty() const {
+		return m_node_counts.isEmpty();
+	}
+
+	int count() const {
+		return isEmpty() ? 0 : m_node_counts.last();
+	}
+
+	int count(const QVector<int>& pattern, Memo& memo) const;
+	void ranges(const QVector<int>& pattern, QVector<QPair<int, int> >& ranges, Memo& memo) const;
+	int select(const QVector<int>& pattern, int k, Memo& memo) const;
+	bool matches(int rank, const QVector<int>& pattern) const;
+	QByteArray word(int rank) const;
+	int memoryUsage() const;
+
+private:
+	void begin(const QVector<int>& pattern, Memo& memo) const;
+	int countBelow(int node, int depth, const QVector<int>& pattern, int wild_from, Memo& memo) const;
+	void rangesBelow(int node, int depth, int rank, const QVector<int>& pattern, int wild_from, QVector<QPair<int, int> >& ranges, Memo& memo) const;
+	static int wildFrom(const QVector<int>& pattern);
+
+private:
+	int m_length;
+	QVector<quint32> m_node_edges;
+	QVector<quint32> m_node_counts;
+	QByteArray m_edge_codes;
+	QVector<quint32> m_edge_targets;
+};
+
+#endif
@@ -19,30 +19,210 @@
 
 #include "wordlist.h"
 
+#include "match_kernel.h"
+#include "random.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
 #include <QFile>
-#include <QTextStream>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QtConcurrentRun>
 
 #include <algorithm>
+#include <climits>
+#include <cstring>
+
+// Layout of precompiled word list created by tools/wordindex.py
+static const char INDEX_MAGIC[4] = { 'C', 'G', 'W', 'L' };
+static const quint32 INDEX_VERSION = 5;
+
+// Store buckets as word graphs instead of packed words; set before loading
+static bool compact_buckets = false;
+
+struct IndexHeader {
+	char magic[4];
+	quint32 version;
+	quint32 source_size;
+	quint32 source_mtime;
+	quint32 buckets;
+	quint32 spellings;
+	quint32 spellings_offset;
+	quint32 alphabet_offset;
+	quint32 alphabet_length;
+	char hash[20];
+};
+
+struct IndexBucket {
+	quint32 count;
+	quint32 offset;
+	quint32 anagram_classes;
+	float match_probability;
+};
+
+struct IndexSpelling {
+	quint32 word_offset;
+	quint32 word_length;
+	quint32 spellings_offset;
+	quint32 spellings_length;
+};
+
+static inline const IndexHeader* indexHeader(const uchar* data) {
+	return reinterpret_cast<const IndexHeader*>(data);
+}
+
+static inline const IndexBucket* indexBuckets(const uchar* data) {
+	return reinterpret_cast<const IndexBucket*>(data + sizeof(IndexHeader));
+}
+
+static inline const IndexSpelling* indexSpellings(const uchar* data) {
+	return reinterpret_cast<const IndexSpelling*>(data + indexHeader(data)->spellings_offset);
+}
+
+static int textSpace(const char* data, int pos, int size) {
+	// Return amount of UTF-8 bytes of whitespace at pos, matching QChar::isSpace()
+	uchar c = data[pos];
+	if ((c == ' ') || ((c >= '\t') && (c <= '\r'))) {
+		return 1;
+	}
+	uchar c1 = ((pos + 1) < size) ? data[pos + 1] : 0;
+	uchar c2 = ((pos + 2) < size) ? data[pos + 2] : 0;
+	if ((c == 0xC2) && ((c1 == 0x85) || (c1 == 0xA0))) {
+		return 2;
+	} else if (((c == 0xE1) && (c1 == 0x9A) && (c2 == 0x80))
+			|| ((c == 0xE2) && (c1 == 0x80) && ((c2 <= 0x8A) || (c2 == 0xA8) || (c2 == 0xA9) || (c2 == 0xAF)))
+			|| ((c == 0xE2) && (c1 == 0x81) && (c2 == 0x9F))
+			|| ((c == 0xE3) && (c1 == 0x80) && (c2 == 0x80))) {
+		return 3;
+	}
+	return 0;
+}
+
+static inline QString decodeWord(const Alphabet& alphabet, const char* letters, int length) {
+	QString word;
+	word.resize(length);
+	for (int i = 0; i < length; ++i) {
+		word[i] = alphabet.letter(uchar(letters[i]));
+	}
+	return word;
+}
+
+static inline QString indexString(const uchar* data, quint32 offset, quint32 length) {
+	return QString::fromRawData(reinterpret_cast<const QChar*>(data + offset), length);
+}
 
 //-----------------------------------------------------------------------------
 
-WordList::WordList(QObject* parent)
-: QObject(parent), m_length(0) {
+WordBucket::WordBucket()
+: m_length(0), m_count(0), m_bits(8), m_lanes(0) {
+}
+
+//-----------------------------------------------------------------------------
+
+QSharedPointer<const WordBucket> WordBucket::create(int length, const QStringList& words, const Alphabet& alphabet, bool compact) {
+	QSharedPointer<WordBucket> bucket(new WordBucket);
+	bucket->read(length, words, alphabet);
+	if (compact) {
+		bucket->compact();
+	} else {
+		bucket->pack();
+	}
+	return bucket;
 }
 
 //-----------------------------------------------------------------------------
 
-QStringList WordList::filter(const QString& known_letters) const {
-	QRegExp filter(known_letters);
+WordStats WordBucket::measure(int length, const QStringList& words, const Alphabet& alphabet) {
+	// Index words without packing them for searches
+	WordBucket bucket;
+	bucket.read(length, words, alphabet);
+	WordStats stats;
+	stats.anagram_classes = bucket.anagramClassCount();
+	stats.match_probability = bucket.matchProbability();
+	return stats;
+}
+
+//-----------------------------------------------------------------------------
+
+int WordBucket::anagramClass(const QString& letters) const {
+	if (letters.length() != (m_length + 1)) {
+		return -1;
+	}
+	LetterCounts counts(m_alphabet, letters);
+	return counts.isValid() ? m_anagram_ids.value(counts, -1) : -1;
+}
+
+//-----------------------------------------------------------------------------
+
+int WordBucket::memoryUsage() const {
+	// Count bytes of the searched words, leaving out indexes both storages keep
+	if (!m_dawg.isEmpty()) {
+		return m_dawg.memoryUsage();
+	}
+	return m_letters.size() + (m_packed.count() * int(sizeof(quint64)));
+}
+
+//-----------------------------------------------------------------------------
+
+qreal WordBucket::matchProbability() const {
+	if (m_count == 0) {
+		return 0;
+	}
+
+	// Average chance that two words share the letter at a position
+	qreal probability = 0;
+	for (int i = 0; i < m_position_counts.count(); ++i) {
+		foreach (int count, m_position_counts.at(i)) {
+			qreal p = count / qreal(m_count);
+			probability += p * p;
+		}
+	}
+	return probability / m_position_counts.count();
+}
+
+//-----------------------------------------------------------------------------
+
+QStringList WordBucket::anagrams(const QString& letters, const QString& known_letters) const {
+	QStringList result;
+	int id = anagramClass(letters);
+	if (id == -1) {
+		return result;
+	}
+
+	bool check_known = (known_letters.length() == letters.length());
+	foreach (int i, m_anagram_words.at(id)) {
+		QString word = this->word(i);
+		bool valid = true;
+		for (int j = 0; check_known && valid && (j <= m_length); ++j) {
+			QChar c = known_letters.at(j);
+			valid = (c == QLatin1Char('.')) || (c == word.at(j));
+		}
+		if (valid) {
+			result += word;
+		}
+	}
+	return result;
+}
+
+//-----------------------------------------------------------------------------
+
+QStringList WordBucket::filter(const QString& known_letters, const QSet<int>& anagram_filters, const CancelToken* cancel) const {
+	Scratch scratch;
+	if (!match(known_letters, anagram_filters, scratch, cancel)) {
+		return QStringList();
+	}
+	const QVector<quint64>& matches = scratch.matches;
 	QStringList filtered;
-	for (QStringList::const_iterator i = m_words.begin(), end = m_words.end(); i != end; ++i) {
-		if (filter.exactMatch(*i)) {
-			QString sorted = *i;
-			std::sort(sorted.begin(), sorted.end());
-			if (m_anagram_filters.contains(sorted)) {
-				continue;
+	for (int block = 0; block < matches.count(); ++block) {
+		// Check for cancellation every few blocks of words to bound how long stopping takes
+		if (cancel && ((block & 0xF) == 0) && cancel->isCancelled()) {
+			return QStringList();
+		}
+		quint64 bits = matches.at(block);
+		for (int i = block * 64; bits; ++i, bits >>= 1) {
+			if (bits & 1) {
+				filtered += word(i);
 			}
-			filtered += *i;
 		}
 	}
 	return filtered;
@@ -50,41 +230,386 @@ QStringList WordList::filter(const QString& known_letters) const {
 
 //-----------------------------------------------------------------------------
 
-void WordList::addAnagramFilter(const QString& word) {
-	QString sorted_letters = word;
-	std::sort(sorted_letters.begin(), sorted_letters.end());
-	m_anagram_filters.append(sorted_letters);
+bool WordBucket::match(const QString& known_letters, const QSet<int>& anagram_filters, Scratch& scratch, const CancelToken* cancel) const {
+	int blocks = (m_count + 63) / 64;
+	QVector<int>& pattern = scratch.pattern;
+	QVector<quint64>& matches = scratch.matches;
+	if (!encodePattern(known_letters, pattern)) {
+		matches.fill(0, blocks);
+		return true;
+	}
+
+	if (!m_dawg.isEmpty()) {
+		// Set bits of words in each run of matching ids
+		matches.fill(0, blocks);
+		QVector<QPair<int, int> >& ranges = scratch.ranges;
+		ranges.resize(0);
+		m_dawg.ranges(pattern, ranges, scratch.memo);
+		for (int i = 0; i < ranges.count(); ++i) {
+			for (int id = ranges.at(i).first; id < ranges.at(i).second; ++id) {
+				matches[id >> 6] |= Q_UINT64_C(1) << (id & 63);
+			}
+		}
+	} else {
+		matches.fill(~Q_UINT64_C(0), blocks);
+		if (m_count % 64) {
+			matches.last() = (Q_UINT64_C(1) << (m_count % 64)) - 1;
+		}
+
+		// Compare known letters of every word in each lane at once
+		int per_lane = 64 / m_bits;
+		quint64 letter_mask = (Q_UINT64_C(1) << m_bits) - 1;
+		for (int lane = 0; lane < m_lanes; ++lane) {
+			if (cancel && cancel->isCancelled()) {
+				return false;
+			}
+			quint64 mask = 0;
+			quint64 value = 0;
+			for (int i = lane * per_lane, end = qMin(i + per_lane, m_length + 1); i < end; ++i) {
+				if (pattern.at(i) == -1) {
+					continue;
+				}
+				int shift = (i - (lane * per_lane)) * m_bits;
+				mask |= letter_mask << shift;
+				value |= quint64(pattern.at(i)) << shift;
+			}
+			if (mask) {
+				matchPackedWords(m_packed.constData() + (lane * m_count), m_count, mask, value, matches.data());
+			}
+		}
+	}
+
+	// Remove words sharing letters with words already used
+	foreach (int id, anagram_filters) {
+		foreach (int i, m_anagram_words.value(id)) {
+			matches[i >> 6] &= ~(Q_UINT64_C(1) << (i & 63));
+		}
+	}
+	return true;
 }
 
 //-----------------------------------------------------------------------------
 
-void WordList::resetAnagramFilters() {
+int WordBucket::randomWord(const QString& known_letters, const QSet<int>& anagram_filters, Random& random, Scratch& scratch, const CancelToken* cancel) const {
+	// Pick the same word as choosing from the list returned by filter()
+	if (!m_dawg.isEmpty()) {
+		// Ranks are ids, so count matches by subtrees and skip used anagrams
+		QVector<int>& pattern = scratch.pattern;
+		if ((cancel && cancel->isCancelled()) || !encodePattern(known_letters, pattern)) {
+			return -1;
+		}
+		QVector<int>& excluded = scratch.excluded;
+		excluded.resize(0);
+		foreach (int id, anagram_filters) {
+			foreach (int i, m_anagram_words.value(id)) {
+				if (m_dawg.matches(i, pattern)) {
+					excluded.append(i);
+				}
+			}
+		}
+		int count = m_dawg.count(pattern, scratch.memo) - excluded.count();
+		if (count <= 0) {
+			return -1;
+		}
+		int k = random.nextInt(count);
+		int skipped = 0;
+		forever {
+			int id = m_dawg.select(pattern, k + skipped, scratch.memo);
+			int below = 0;
+			foreach (int i, excluded) {
+				below += (i <= id);
+			}
+			if (below == skipped) {
+				return id;
+			}
+			skipped = below;
+		}
+	}
+
+	if (!match(known_letters, anagram_filters, scratch, cancel)) {
+		return -1;
+	}
+	const QVector<quint64>& matches = scratch.matches;
+	int count = countMatches(matches.constData(), matches.count());
+	if (count == 0) {
+		return -1;
+	}
+	return selectMatch(matches.constData(), matches.count(), random.nextInt(count));
+}
+
+//-----------------------------------------------------------------------------
+
+QString WordBucket::word(int id) const {
+	if ((id < 0) || (id >= m_count)) {
+		return QString();
+	}
+	return decodeWord(m_alphabet, wordCodes(id).constData(), m_length + 1);
+}
+
+//-----------------------------------------------------------------------------
+
+QByteArray WordBucket::wordCodes(int id) const {
+	if (!m_dawg.isEmpty()) {
+		return m_dawg.word(id);
+	}
+	return QByteArray::fromRawData(m_letters.constData() + (id * (m_length + 1)), m_length + 1);
+}
+
+//-----------------------------------------------------------------------------
+
+namespace {
+	// Order ids by the letter codes of their words
+	class WordLess {
+	public:
+		WordLess(const char* letters, int length) : m_letters(letters), m_length(length) {
+		}
+
+		bool operator()(int a, int b) const {
+			return memcmp(m_letters + (a * m_length), m_letters + (b * m_length), m_length) < 0;
+		}
+
+	private:
+		const char* m_letters;
+		int m_length;
+	};
+}
+
+void WordBucket::compact() {
+	if (!m_count) {
+		pack();
+		return;
+	}
+
+	// Words are already sorted without repeats, so ranks in the graph are ids
+	m_dawg = WordDawg::create(m_letters, m_length + 1);
+	m_letters = QByteArray();
+}
+
+//-----------------------------------------------------------------------------
+
+void WordBucket::read(int length, const QStringList& words, const Alphabet& alphabet) {
+	m_length = length;
+	m_letters.reserve(words.count() * (length + 1));
+	m_alphabet = alphabet;
+
+	// Store each letter as its code in the alphabet, adding letters the alphabet is missing
+	foreach (const QString& word, words) {
+		if (word.length() != (length + 1)) {
+			continue;
+		}
+		int size = m_letters.size();
+		for (int i = 0; i <= length; ++i) {
+			int code = m_alphabet.add(word.at(i));
+			if (code == -1) {
+				// Skip words with letters beyond what the alphabet can hold
+				break;
+			}
+			m_letters.append(char(code));
+		}
+		if (m_letters.size() == (size + length + 1)) {
+			m_count++;
+		} else {
+			m_letters.truncate(size);
+		}
+	}
+
+	// Sort words by their codes and drop repeats, so that ids are the same
+	// as ranks in a word graph of the bucket
+	const char* letters = m_letters.constData();
+	int width = length + 1;
+	bool sorted = true;
+	for (int i = 1; sorted && (i < m_count); ++i) {
+		sorted = (memcmp(letters + ((i - 1) * width), letters + (i * width), width) < 0);
+	}
+	if (!sorted) {
+		QVector<int> order(m_count);
+		for (int i = 0; i < m_count; ++i) {
+			order[i] = i;
+		}
+		std::sort(order.begin(), order.end(), WordLess(letters, width));
+		QByteArray unique;
+		unique.reserve(m_letters.size());
+		for (int i = 0; i < m_count; ++i) {
+			const char* word = letters + (order.at(i) * width);
+			if ((i == 0) || (memcmp(letters + (order.at(i - 1) * width), word, width) != 0)) {
+				unique.append(word, width);
+			}
+		}
+		m_letters = unique;
+		m_count = m_letters.size() / width;
+		letters = m_letters.constData();
+	}
+
+	// Index words by letter positions and anagrams
+	m_position_counts.fill(QVector<int>(m_alphabet.count()), length + 1);
+	for (int i = 0; i < m_count; ++i) {
+		const char* word = letters + (i * width);
+
+		// Track how many words have each letter at each position
+		for (int j = 0; j <= length; ++j) {
+			m_position_counts[j][uchar(word[j])]++;
+		}
+
+		// Group words that share the same letters
+		LetterCounts counts(m_alphabet, word, length + 1);
+		int id = m_anagram_ids.value(counts, -1);
+		if (id == -1) {
+			id = m_anagram_words.count();
+			m_anagram_ids.insert(counts, id);
+			m_anagram_words.append(QVector<int>());
+		}
+		m_anagram_words[id].append(i);
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+bool WordBucket::encodePattern(const QString& known_letters, QVector<int>& pattern) const {
+	if (known_letters.length() != (m_length + 1)) {
+		return false;
+	}
+	pattern.resize(m_length + 1);
+	for (int i = 0; i <= m_length; ++i) {
+		QChar c = known_letters.at(i);
+		pattern[i] = (c == QLatin1Char('.')) ? -1 : m_alphabet.code(c);
+		if ((pattern.at(i) == -1) && (c != QLatin1Char('.'))) {
+			return false;
+		}
+	}
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+
+void WordBucket::pack() {
+	// Use the fewest bits that hold every letter code, so that a lane holds up to 12 letters
+	int size = m_alphabet.count();
+	m_bits = (size <= 32) ? 5 : ((size <= 64) ? 6 : 8);
+	int per_lane = 64 / m_bits;
+	m_lanes = (m_length + per_lane) / per_lane;
+
+	// Store each lane of every word together for matching many words in a row
+	m_packed.fill(0, m_lanes * m_count);
+	const char* letters = m_letters.constData();
+	for (int i = 0; i < m_count; ++i) {
+		const char* word = letters + (i * (m_length + 1));
+		for (int j = 0; j <= m_length; ++j) {
+			int lane = j / per_lane;
+			int shift = (j % per_lane) * m_bits;
+			m_packed[(lane * m_count) + i] |= quint64(uchar(word[j])) << shift;
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+WordFilter::WordFilter(QSharedPointer<const WordBucket> words)
+: m_words(words) {
+}
+
+//-----------------------------------------------------------------------------
+
+QString WordFilter::randomWord(const QString& known_letters, Random& random, const CancelToken* cancel) {
+	return m_words ? m_words->word(m_words->randomWord(known_letters, m_anagram_filters, random, m_scratch, cancel)) : QString();
+}
+
+//-----------------------------------------------------------------------------
+
+void WordFilter::addAnagramFilter(const QString& word) {
+	if (m_words) {
+		m_anagram_filters.insert(m_words->anagramClass(word));
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+void WordFilter::removeAnagramFilter(const QString& word) {
+	if (m_words) {
+		m_anagram_filters.remove(m_words->anagramClass(word));
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+void WordFilter::resetAnagramFilters() {
 	m_anagram_filters.clear();
 }
 
 //-----------------------------------------------------------------------------
 
+WordList::WordList(QObject* parent)
+: QObject(parent), m_ready(false) {
+	m_loader = new QFutureWatcher<void>(this);
+	connect(m_loader, SIGNAL(finished()), this, SLOT(dataLoaded()));
+}
+
+//-----------------------------------------------------------------------------
+
+bool WordList::isReady() const {
+	QMutexLocker locker(&m_ready_mutex);
+	return m_ready;
+}
+
+//-----------------------------------------------------------------------------
+
+QByteArray WordList::hash() const {
+	return isLoaded() ? m_data->hash() : QByteArray();
+}
+
+//-----------------------------------------------------------------------------
+
+QStringList WordList::anagrams(const QString& letters, const QString& known_letters) const {
+	return words(letters.length() - 1)->anagrams(letters, known_letters);
+}
+
+//-----------------------------------------------------------------------------
+
+QSharedPointer<const WordBucket> WordList::words(int length) const {
+	return isLoaded() ? m_data->bucket(length) : QSharedPointer<const WordBucket>(new WordBucket);
+}
+
+//-----------------------------------------------------------------------------
+
 void WordList::setLanguage(const QString& langcode) {
 	if (m_langcode == langcode) {
 		return;
 	}
 	m_langcode = langcode;
 
+	// Word lists in different threads share the words of each language
 	static QHash<QString, QSharedPointer<WordListData> > languages;
+	static QMutex languages_mutex;
+	QMutexLocker languages_locker(&languages_mutex);
 	if (!languages.contains(langcode)) {
 		languages.insert(langcode, QSharedPointer<WordListData>(new WordListData(langcode)));
 	}
-	m_data = languages[langcode];
-	resetWords();
+	QSharedPointer<WordListData> data = languages.value(langcode);
+	languages_locker.unlock();
+
+	QMutexLocker locker(&m_ready_mutex);
+	m_data = data;
+	m_ready = false;
+	locker.unlock();
 
 	emit languageChanged(m_langcode);
+
+	// Read words in the background; ready() is emitted when they are available
+	m_loader->setFuture(QtConcurrent::run(m_data.data(), &WordListData::load));
 }
 
 //-----------------------------------------------------------------------------
 
-void WordList::setLength(int length) {
-	m_length = length;
-	resetWords();
+bool WordList::waitForReady(const CancelToken* cancel) {
+	if (!m_data) {
+		return true;
+	}
+	if (!m_data->waitForLoaded(cancel)) {
+		return false;
+	}
+
+	QMutexLocker locker(&m_ready_mutex);
+	m_ready = true;
+	return true;
 }
 
 //-----------------------------------------------------------------------------
@@ -102,50 +627,317 @@ QString WordList::defaultLanguage() {
 
 //-----------------------------------------------------------------------------
 
-void WordList::resetWords() {
-	m_words = m_data->words(m_length);
+void WordList::setCompact(bool compact) {
+	compact_buckets = compact;
+}
+
+//-----------------------------------------------------------------------------
+
+void WordList::dataLoaded() {
+	waitForReady();
+	emit ready();
 }
 
 //-----------------------------------------------------------------------------
 
 WordList::WordListData::WordListData(const QString& language) :
-	m_maximum_length(0)
+	m_index_data(0),
+	m_maximum_length(0),
+	m_language(language),
+	m_loaded(false)
 {
+}
+
+//-----------------------------------------------------------------------------
+
+bool WordList::WordListData::isLoaded() const {
+	QMutexLocker locker(&m_loaded_mutex);
+	return m_loaded;
+}
+
+//-----------------------------------------------------------------------------
+
+void WordList::WordListData::load() {
+	// Only read words once even if several word lists request them
+	QMutexLocker load_locker(&m_load_mutex);
+	if (isLoaded()) {
+		return;
+	}
+
 	// Read words from disk
+	if (!openIndex(m_language)) {
+		readText(m_language);
+	}
+
+	// Use generated letters of shipped languages, or letters stored in index
+	m_alphabet = Alphabet::forLanguage(m_language);
+	if (m_alphabet.isEmpty() && m_index_data) {
+		const IndexHeader* header = indexHeader(m_index_data);
+		m_alphabet = Alphabet(reinterpret_cast<const ushort*>(m_index_data + header->alphabet_offset), header->alphabet_length);
+	}
+
+	// Adjust maximum length to account for maximum amount of words
+	for (int i = m_maximum_length - 1; i > 0; --i) {
+		if (count(i) >= 20) {
+			m_maximum_length = i + 1;
+			break;
+		}
+	}
+
+	QMutexLocker locker(&m_loaded_mutex);
+	m_loaded = true;
+	m_loaded_condition.wakeAll();
+}
+
+//-----------------------------------------------------------------------------
+
+bool WordList::WordListData::waitForLoaded(const CancelToken* cancel) const {
+	// Wake up regularly to check if caller has given up waiting
+	QMutexLocker locker(&m_loaded_mutex);
+	while (!m_loaded) {
+		if (cancel && cancel->isCancelled()) {
+			return false;
+		}
+		m_loaded_condition.wait(&m_loaded_mutex, cancel ? 10 : ULONG_MAX);
+	}
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+
+QStringList WordList::WordListData::spellings(const QString& word) const {
+	if (!m_index_data) {
+		QMutexLocker locker(&m_buckets_mutex);
+		return textSpellings().value(word, QStringList(word.toLower()));
+	}
+
+	// Binary search sorted spellings table of index
+	const IndexSpelling* spellings = indexSpellings(m_index_data);
+	int first = 0;
+	int last = indexHeader(m_index_data)->spellings;
+	while (first < last) {
+		int middle = (first + last) / 2;
+		const IndexSpelling& entry = spellings[middle];
+		int compare = indexString(m_index_data, entry.word_offset, entry.word_length).compare(word);
+		if (compare < 0) {
+			first = middle + 1;
+		} else if (compare > 0) {
+			last = middle;
+		} else {
+			return indexString(m_index_data, entry.spellings_offset, entry.spellings_length).split(" ", QString::SkipEmptyParts);
+		}
+	}
+	return QStringList(word.toLower());
+}
+
+//-----------------------------------------------------------------------------
+
+QSharedPointer<const WordBucket> WordList::WordListData::bucket(int length) const {
+	// Create words of length from index or text the first time they are requested
+	QMutexLocker locker(&m_buckets_mutex);
+	if (m_buckets.contains(length)) {
+		return m_buckets.value(length);
+	}
+
+	QSharedPointer<const WordBucket> bucket = WordBucket::create(length, readWords(length), m_alphabet, compact_buckets);
+	m_buckets.insert(length, bucket);
+	return bucket;
+}
+
+//-----------------------------------------------------------------------------
+
+WordStats WordList::WordListData::stats(int length) const {
+	WordStats stats;
+	if (!count(length)) {
+		return stats;
+	}
+
+	// Use values measured when index was generated
+	if (m_index_data) {
+		const IndexBucket& bucket = indexBuckets(m_index_data)[length];
+		stats.anagram_classes = bucket.anagram_classes;
+		stats.match_probability = bucket.match_probability;
+		return stats;
+	}
+
+	// Measure text word list the first time a length is checked
+	QMutexLocker locker(&m_buckets_mutex);
+	if (m_stats.contains(length)) {
+		return m_stats.value(length);
+	}
+	QSharedPointer<const WordBucket> bucket = m_buckets.value(length);
+	if (bucket) {
+		stats.anagram_classes = bucket->anagramClassCount();
+		stats.match_probability = bucket->matchProbability();
+	} else {
+		stats = WordBucket::measure(length, readWords(length), m_alphabet);
+	}
+	m_stats.insert(length, stats);
+	return stats;
+}
+
+//-----------------------------------------------------------------------------
+
+QStringList WordList::WordListData::readWords(int length) const {
+	int total = count(length);
+	QStringList words;
+	const quint32 offset = (m_index_data && total) ? indexBuckets(m_index_data)[length].offset : 0;
+	const QVector<TextLine> lines = m_text_lines.value(length);
+	for (int i = 0; i < total; ++i) {
+		if (m_index_data) {
+			words.append(indexString(m_index_data, offset + (i * (length + 1) * sizeof(QChar)), length + 1));
+		} else {
+			const TextLine& line = lines.at(i);
+			words.append(QString::fromUtf8(m_source.constData() + line.offset, line.size).toUpper());
+		}
+	}
+	return words;
+}
+
+//-----------------------------------------------------------------------------
+
+int WordList::WordListData::count(int length) const {
+	if (m_index_data) {
+		return ((length >= 0) && (length < int(indexHeader(m_index_data)->buckets))) ? indexBuckets(m_index_data)[length].count : 0;
+	} else {
+		return m_text_lines.value(length).size();
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+bool WordList::WordListData::openIndex(const QString& language) {
+#if (Q_BYTE_ORDER == Q_LITTLE_ENDIAN)
+	m_index.setFileName("connectagram:" + language + "/words.bin");
+	if (!m_index.open(QFile::ReadOnly)) {
+		return false;
+	}
+	qint64 size = m_index.size();
+	const uchar* data = (size >= qint64(sizeof(IndexHeader))) ? m_index.map(0, size) : 0;
+	if (!data) {
+		m_index.close();
+		return false;
+	}
+
+	// Verify index is readable and matches text word list
+	const IndexHeader* header = indexHeader(data);
+	QFileInfo source("connectagram:" + language + "/words");
+	bool valid = (memcmp(header->magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) == 0)
+			&& (header->version == INDEX_VERSION)
+			&& (!source.exists() || (source.size() == header->source_size))
+			&& ((sizeof(IndexHeader) + (qint64(header->buckets) * sizeof(IndexBucket))) <= quint64(size))
+			&& ((header->spellings_offset + (qint64(header->spellings) * sizeof(IndexSpelling))) <= quint64(size))
+			&& ((header->alphabet_offset + (qint64(header->alphabet_length) * sizeof(QChar))) <= quint64(size));
+	for (quint32 i = 0; valid && (i < header->buckets); ++i) {
+		const IndexBucket& bucket = indexBuckets(data)[i];
+		valid = (bucket.offset + (qint64(bucket.count) * (i + 1) * sizeof(QChar))) <= quint64(size);
+	}
+	for (quint32 i = 0; valid && (i < header->spellings); ++i) {
+		const IndexSpelling& spelling = indexSpellings(data)[i];
+		valid = ((spelling.word_offset + (qint64(spelling.word_length) * sizeof(QChar))) <= quint64(size))
+				&& ((spelling.spellings_offset + (qint64(spelling.spellings_length) * sizeof(QChar))) <= quint64(size));
+	}
+
+	// Only hash text word list if it was modified after index was generated,
+	// as edits that keep its size still change its hash
+#if (QT_VERSION >= QT_VERSION_CHECK(5,8,0))
+	quint32 mtime = source.lastModified().toSecsSinceEpoch();
+#else
+	quint32 mtime = source.lastModified().toTime_t();
+#endif
+	if (valid && source.exists() && (mtime != header->source_mtime)) {
+		QFile file(source.filePath());
+		valid = file.open(QFile::ReadOnly)
+				&& (QCryptographicHash::hash(file.readAll(), QCryptographicHash::Sha1) == QByteArray::fromRawData(header->hash, sizeof(header->hash)));
+	}
+	if (!valid) {
+		m_index.unmap(const_cast<uchar*>(data));
+		m_index.close();
+		return false;
+	}
+
+	m_index_data = data;
+	m_hash = QByteArray(header->hash, sizeof(header->hash));
+	m_maximum_length = header->buckets;
+	return true;
+#else
+	Q_UNUSED(language);
+	return false;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+
+void WordList::WordListData::readText(const QString& language) {
 	QFile file("connectagram:" + language + "/words");
-	if (!file.open(QFile::ReadOnly | QIODevice::Text)) {
+	if (!file.open(QFile::ReadOnly)) {
 		return;
 	}
+	m_source = file.readAll();
+	file.close();
+	m_hash = QCryptographicHash::hash(m_source, QCryptographicHash::Sha1);
 
-	QTextStream in(&file);
-	in.setCodec("UTF-8");
-	while (!in.atEnd()) {
-		QStringList spellings = in.readLine().simplified().split(" ", QString::SkipEmptyParts);
-		if (spellings.isEmpty()) {
-			continue;
+	// Only find where words are; they are decoded when their length is requested
+	const char* data = m_source.constData();
+	int size = m_source.size();
+	int pos = m_source.startsWith("\xEF\xBB\xBF") ? 3 : 0;
+	while (pos < size) {
+		int space = 0;
+		while ((pos < size) && (data[pos] != '\n') && (space = textSpace(data, pos, size))) {
+			pos += space;
 		}
+		int start = pos;
+
+		// Count UTF-16 units of word from UTF-8 lead bytes
+		int length = 0;
+		while ((pos < size) && !textSpace(data, pos, size)) {
+			uchar c = data[pos];
+			if ((c & 0xC0) != 0x80) {
+				length += (c >= 0xF0) ? 2 : 1;
+			}
+			++pos;
+		}
+		int end = pos;
+
+		// Note lines that have alternate spellings
+		bool has_spellings = false;
+		while ((pos < size) && (data[pos] != '\n')) {
+			space = textSpace(data, pos, size);
+			has_spellings |= (space == 0);
+			pos += qMax(space, 1);
+		}
+		++pos;
 
-		QString word = spellings.takeFirst();
-		int length = word.length();
 		if (length < 5) {
 			continue;
 		}
-
 		m_maximum_length = qMax(m_maximum_length, length);
-		m_all_words[length - 1].append(word.toUpper());
-
-		if (!spellings.isEmpty()) {
-			m_spellings[word] = spellings;
+		TextLine line = { start, end - start };
+		m_text_lines[length - 1].append(line);
+		if (has_spellings) {
+			m_spelling_lines.append(start);
 		}
 	}
+}
 
-	// Adjust maximum length to account for maximum amount of words
-	for (int i = m_maximum_length - 1; i > 0; --i) {
-		if (m_all_words[i].size() >= 20) {
-			m_maximum_length = i + 1;
-			break;
+//-----------------------------------------------------------------------------
+
+const QHash<QString, QStringList>& WordList::WordListData::textSpellings() const {
+	// Parse alternate spellings the first time they are requested
+	if (!m_spelling_lines.isEmpty()) {
+		int size = m_source.size();
+		foreach (int start, m_spelling_lines) {
+			int end = m_source.indexOf('\n', start);
+			if (end == -1) {
+				end = size;
+			}
+			QStringList spellings = QString::fromUtf8(m_source.constData() + start, end - start).simplified().split(" ", QString::SkipEmptyParts);
+			QString word = spellings.takeFirst();
+			m_spellings[word] = spellings;
 		}
+		m_spelling_lines.clear();
 	}
+	return m_spellings;
 }
 
 //-----------------------------------------------------------------------------
@@ -20,10 +20,122 @@
 #ifndef WORD_LIST_H
 #define WORD_LIST_H
 
+#include "alphabet.h"
+#include "cancel_token.h"
+#include "word_dawg.h"
+
+#include <QFile>
+#include <QFutureWatcher>
 #include <QHash>
+#include <QMutex>
+#include <QSet>
 #include <QSharedPointer>
 #include <QStringList>
 #include <QObject>
+#include <QVector>
+#include <QWaitCondition>
+class Random;
+
+// Summary of the words of one length, stored in the index or measured when first needed
+struct WordStats {
+	WordStats() : anagram_classes(0), match_probability(0) {
+	}
+
+	int anagram_classes;
+	qreal match_probability;
+};
+
+//-----------------------------------------------------------------------------
+
+// Words of a single length; they never change once created so that every
+// thread can search them without locking
+class WordBucket {
+public:
+	// Buffers kept between searches so that picking a word does not allocate
+	struct Scratch {
+		QVector<int> pattern;
+		QVector<quint64> matches;
+		QVector<int> excluded;
+		QVector<QPair<int, int> > ranges;
+		WordDawg::Memo memo;
+	};
+
+	WordBucket();
+
+	static QSharedPointer<const WordBucket> create(int length, const QStringList& words, const Alphabet& alphabet = Alphabet(), bool compact = false);
+	static WordStats measure(int length, const QStringList& words, const Alphabet& alphabet = Alphabet());
+
+	const Alphabet& alphabet() const {
+		return m_alphabet;
+	}
+
+	int count() const {
+		return m_count;
+	}
+
+	bool isCompact() const {
+		return !m_dawg.isEmpty();
+	}
+
+	int anagramClass(const QString& letters) const;
+	int memoryUsage() const;
+
+	int anagramClassCount() const {
+		return m_anagram_words.count();
+	}
+
+	qreal matchProbability() const;
+
+	QStringList anagrams(const QString& letters, const QString& known_letters = QString()) const;
+	QStringList filter(const QString& known_letters, const QSet<int>& anagram_filters = QSet<int>(), const CancelToken* cancel = 0) const;
+	bool match(const QString& known_letters, const QSet<int>& anagram_filters, Scratch& scratch, const CancelToken* cancel = 0) const;
+	int randomWord(const QString& known_letters, const QSet<int>& anagram_filters, Random& random, Scratch& scratch, const CancelToken* cancel = 0) const;
+	QString word(int id) const;
+
+private:
+	void compact();
+	bool encodePattern(const QString& known_letters, QVector<int>& pattern) const;
+	void pack();
+	void read(int length, const QStringList& words, const Alphabet& alphabet);
+	QByteArray wordCodes(int id) const;
+
+private:
+	int m_length;
+	int m_count;
+	QByteArray m_letters;
+	Alphabet m_alphabet;
+	QVector<QVector<int> > m_position_counts;
+	int m_bits;
+	int m_lanes;
+	QVector<quint64> m_packed;
+	WordDawg m_dawg;
+	QHash<LetterCounts, int> m_anagram_ids;
+	QVector<QVector<int> > m_anagram_words;
+};
+
+//-----------------------------------------------------------------------------
+
+// Words that one puzzle may still use; each generated puzzle has its own
+class WordFilter {
+public:
+	explicit WordFilter(QSharedPointer<const WordBucket> words = QSharedPointer<const WordBucket>());
+
+	const WordBucket* words() const {
+		return m_words.data();
+	}
+
+	QString randomWord(const QString& known_letters, Random& random, const CancelToken* cancel = 0);
+	void addAnagramFilter(const QString& word);
+	void removeAnagramFilter(const QString& word);
+	void resetAnagramFilters();
+
+private:
+	QSharedPointer<const WordBucket> m_words;
+	QSet<int> m_anagram_filters;
+	WordBucket::Scratch m_scratch;
+};
+
+//-----------------------------------------------------------------------------
 
 class WordList : public QObject {
 	Q_OBJECT
@@ -32,69 +144,114 @@ public:
 	WordList(QObject* parent = 0);
 
 	bool isEmpty() const {
-		return m_data->isEmpty();
+		return !isLoaded() || m_data->isEmpty();
 	}
 
+	bool isReady() const;
+
 	QString language() const {
 		return m_langcode;
 	}
 
 	int maximumLength() const {
-		return m_data->maximumLength();
+		return isLoaded() ? m_data->maximumLength() : 0;
 	}
 
-	QStringList filter(const QString& known_letters) const;
+	QByteArray hash() const;
+	QStringList anagrams(const QString& letters, const QString& known_letters = QString()) const;
 
 	QStringList spellings(const QString& word) const {
-		return m_data->spellings(word);
+		return isLoaded() ? m_data->spellings(word) : QStringList(word.toLower());
+	}
+
+	QSharedPointer<const WordBucket> words(int length) const;
+
+	WordStats stats(int length) const {
+		return isLoaded() ? m_data->stats(length) : WordStats();
 	}
 
-	void addAnagramFilter(const QString& word);
-	void resetAnagramFilters();
 	void setLanguage(const QString& langcode);
-	void setLength(int length);
+	bool waitForReady(const CancelToken* cancel = 0);
 
 	static QString defaultLanguage();
+	static void setCompact(bool compact);
 
 signals:
 	void languageChanged(const QString& language);
+	void ready();
+
+private slots:
+	void dataLoaded();
 
 private:
-	void resetWords();
+	bool isLoaded() const {
+		return m_data && m_data->isLoaded();
+	}
 
 private:
 	class WordListData {
 	public:
 		explicit WordListData(const QString& language = QString());
 
+		bool isLoaded() const;
+		void load();
+		bool waitForLoaded(const CancelToken* cancel = 0) const;
+
 		bool isEmpty() const {
-			return m_all_words.isEmpty();
+			return m_maximum_length == 0;
+		}
+
+		QByteArray hash() const {
+			return m_hash;
 		}
 
 		int maximumLength() const {
 			return m_maximum_length;
 		}
 
-		QStringList spellings(const QString& word) const {
-			return m_spellings.value(word, QStringList(word.toLower()));
-		}
+		QSharedPointer<const WordBucket> bucket(int length) const;
+		QStringList spellings(const QString& word) const;
 
-		QStringList words(int length) const {
-			return m_all_words.value(length);
-		}
+		WordStats stats(int length) const;
 
 	private:
-		QHash<int, QStringList> m_all_words;
-		QHash<QString, QStringList> m_spellings;
+		struct TextLine {
+			int offset;
+			int size;
+		};
+
+		int count(int length) const;
+		bool openIndex(const QString& language);
+		void readText(const QString& language);
+		QStringList readWords(int length) const;
+		const QHash<QString, QStringList>& textSpellings() const;
+
+	private:
+		mutable QHash<int, QSharedPointer<const WordBucket> > m_buckets;
+		mutable QMutex m_buckets_mutex;
+		QByteArray m_source;
+		QHash<int, QVector<TextLine> > m_text_lines;
+		mutable QVector<int> m_spelling_lines;
+		mutable QHash<QString, QStringList> m_spellings;
+		QByteArray m_hash;
+		Alphabet m_alphabet;
+		mutable QHash<int, WordStats> m_stats;
+		QFile m_index;
+		const uchar* m_index_data;
 		int m_maximum_length;
+		QString m_language;
+		QMutex m_load_mutex;
+		bool m_loaded;
+		mutable QMutex m_loaded_mutex;
+		mutable QWaitCondition m_loaded_condition;
 	};
 
 private:
 	QString m_langcode;
 	QSharedPointer<WordListData> m_data;
-	QStringList m_words;
-	QStringList m_anagram_filters;
-	int m_length;
+	QFutureWatcher<void>* m_loader;
+	bool m_ready;
+	mutable QMutex m_ready_mutex;
 };
 
 #endif
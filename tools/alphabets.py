@@ -0,0 +1,99 @@
+#!/usr/bin/env python3
+#
+# Copyright (C) 2013 Graeme Gott <graeme@gottcode.org>
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+"""alphabets.py: Generate table of letters used by each Connectagram word list.
+
+Each shipped language gets a sorted table of the UTF-16 code points of the
+uppercase letters in its word list. Connectagram gives each letter a dense
+code from its place in the table, so that letters can index small arrays.
+Word lists of other languages store their letters in the binary index
+created by wordindex.py instead.
+"""
+
+
+import argparse
+import os
+import struct
+
+from wordindex import MINIMUM_LENGTH, upper, utf16
+
+
+def letters(path):
+    """Return sorted UTF-16 units of words that Connectagram loads from path."""
+    result = set()
+    with open(path, mode='rb') as f:
+        for line in f.read().decode('utf-8').split('\n'):
+            parts = line.split()
+            if parts and (len(utf16(parts[0])) // 2 >= MINIMUM_LENGTH):
+                word = utf16(upper(parts[0]))
+                result.update(struct.unpack('<{0}H'.format(len(word) // 2), word))
+    return sorted(result)
+
+
+def main():
+    parser = argparse.ArgumentParser(
+            description='Generate table of letters used by each word list')
+    parser.add_argument('DATA',
+            help='directory containing a folder of words for each language')
+    parser.add_argument('-o', '--out', type=str, default='src/alphabets.h',
+            help='place table in file OUT instead of src/alphabets.h')
+    args = parser.parse_args()
+
+    languages = sorted(d for d in os.listdir(args.DATA)
+            if os.path.isfile(os.path.join(args.DATA, d, 'words')))
+
+    lines = ['// Generated by tools/alphabets.py; do not edit',
+            '',
+            '#ifndef ALPHABETS_H',
+            '#define ALPHABETS_H',
+            '',
+            '#include <qglobal.h>',
+            '',
+            'struct LanguageAlphabet {',
+            '\tconst char* language;',
+            '\tconst ushort* letters;',
+            '\tint count;',
+            '};',
+            '']
+    entries = []
+    for language in languages:
+        table = letters(os.path.join(args.DATA, language, 'words'))
+        codes = ['0x{0:04X}'.format(c) for c in table]
+        name = 'ALPHABET_' + language.upper().replace('-', '_')
+        lines.append('// {0}'.format(''.join(chr(c) for c in table
+                if not 0xD800 <= c <= 0xDFFF)))
+        lines.append('static const ushort {0}[] = {{'.format(name))
+        for i in range(0, len(codes), 8):
+            lines.append('\t' + ', '.join(codes[i:i + 8]) + ',')
+        lines.append('};')
+        lines.append('')
+        entries.append('\t{{ "{0}", {1}, {2} }}'.format(language, name, len(codes)))
+    lines.append('static const LanguageAlphabet LANGUAGE_ALPHABETS[] = {')
+    lines.append(',\n'.join(entries))
+    lines.append('};')
+    lines.append('')
+    lines.append('static const int LANGUAGE_ALPHABETS_COUNT = {0};'.format(len(entries)))
+    lines.append('')
+    lines.append('#endif')
+
+    with open(args.out, mode='w', encoding='utf-8') as f:
+        f.write('\n'.join(lines) + '\n')
+    print("Alphabets generated and placed in file '{0}'".format(args.out))
+
+
+if __name__ == '__main__':
+    main()
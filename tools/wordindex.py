@@ -0,0 +1,162 @@
+#!/usr/bin/env python3
+#
+# Copyright (C) 2013 Graeme Gott <graeme@gottcode.org>
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+"""wordindex.py: Precompile Connectagram word list into binary index.
+
+The index is memory mapped by Connectagram instead of parsing the text
+word list. All values are little endian. The layout is:
+
+    header      magic 'CGWL', version, size of text word list in bytes,
+                modification time of text word list in seconds since
+                the epoch, amount of length buckets, amount of spellings, offset
+                of spellings table, offset and length of alphabet,
+                SHA-1 of text word list
+    buckets     amount of words, offset of words, amount of anagram
+                classes and chance that two words share the letter at a
+                position (32-bit float) for each length, starting with
+                words of length 1
+    spellings   offset and length of word, offset and length of space
+                separated spellings, sorted by word
+    words       uppercase words of each bucket as fixed width UTF-16
+    strings     UTF-16 strings referenced by spellings table, followed
+                by sorted UTF-16 units of every word as the alphabet
+
+Offsets are in bytes from start of file, lengths are in UTF-16 units.
+"""
+
+
+import argparse
+from collections import defaultdict
+import hashlib
+import os
+import struct
+
+
+MAGIC = b'CGWL'
+VERSION = 5
+MINIMUM_LENGTH = 5
+
+
+def utf16(text):
+    """Return text encoded the same way Connectagram stores it in memory."""
+    return text.encode('utf-16-le')
+
+
+def upper(word):
+    """Return uppercase word, keeping letters without a single letter uppercase."""
+    return ''.join(c.upper() if len(c.upper()) == 1 else c for c in word)
+
+
+def measure(words):
+    """Return amount of anagram classes and letter match chance of words."""
+    # Connectagram drops repeated words when reading a bucket
+    words = set(words)
+    if not words:
+        return 0, 0.0
+    classes = set()
+    positions = None
+    for word in words:
+        units = struct.unpack('<{0}H'.format(len(word) // 2), word)
+        classes.add(tuple(sorted(units)))
+        if positions is None:
+            positions = [defaultdict(int) for unit in units]
+        for i, unit in enumerate(units):
+            positions[i][unit] += 1
+    probability = sum((count / len(words)) ** 2
+            for position in positions for count in position.values())
+    return len(classes), probability / len(positions)
+
+
+def main():
+    parser = argparse.ArgumentParser(
+            description='Precompile Connectagram word list into binary index')
+    parser.add_argument('FILE',
+            help='file containing Connectagram word list')
+    parser.add_argument('-o', '--out', type=str,
+            help='place index in file OUT instead of FILE.bin')
+    args = parser.parse_args()
+
+    # Read words the same way Connectagram parses them
+    with open(args.FILE, mode='rb') as f:
+        source = f.read()
+    buckets = defaultdict(list)
+    spellings = {}
+    for line in source.decode('utf-8').split('\n'):
+        parts = line.split()
+        if not parts:
+            continue
+        word = parts[0]
+        length = len(utf16(word)) // 2
+        if length < MINIMUM_LENGTH:
+            continue
+        buckets[length - 1].append(utf16(upper(word)))
+        if len(parts) > 1:
+            spellings[word] = ' '.join(parts[1:])
+    bucket_count = (max(buckets) + 1) if buckets else 0
+
+    # Lay out sections
+    header = struct.Struct('<4sIIIIIIII20s')
+    bucket = struct.Struct('<IIIf')
+    spelling = struct.Struct('<IIII')
+    offset = header.size + (bucket.size * bucket_count)
+    spellings_offset = offset
+    offset += spelling.size * len(spellings)
+
+    bucket_table = []
+    words = []
+    for i in range(bucket_count):
+        classes, probability = measure(buckets[i])
+        bucket_table.append(bucket.pack(len(buckets[i]), offset, classes,
+                probability))
+        for word in buckets[i]:
+            words.append(word)
+            offset += len(word)
+
+    spelling_table = []
+    strings = []
+    for word in sorted(spellings, key=lambda w: w.encode('utf-16-be')):
+        key = utf16(word)
+        value = utf16(spellings[word])
+        spelling_table.append(spelling.pack(offset, len(key) // 2,
+                offset + len(key), len(value) // 2))
+        strings.append(key + value)
+        offset += len(key) + len(value)
+
+    # Store letters of languages without a generated alphabet in Connectagram
+    units = set()
+    for word in words:
+        units.update(struct.unpack('<{0}H'.format(len(word) // 2), word))
+    alphabet = struct.pack('<{0}H'.format(len(units)), *sorted(units))
+    alphabet_offset = offset
+    strings.append(alphabet)
+
+    # Save index to disk
+    outf = args.out if args.out else args.FILE + '.bin'
+    with open(outf, mode='wb') as f:
+        f.write(header.pack(MAGIC, VERSION, len(source),
+                int(os.stat(args.FILE).st_mtime), bucket_count,
+                len(spellings), spellings_offset, alphabet_offset,
+                len(alphabet) // 2, hashlib.sha1(source).digest()))
+        f.write(b''.join(bucket_table))
+        f.write(b''.join(spelling_table))
+        f.write(b''.join(words))
+        f.write(b''.join(strings))
+    print("Index generated and placed in file '{0}'".format(outf))
+
+
+if __name__ == '__main__':
+    main()